@@ -10,6 +10,8 @@
 #include <vector>
 #include <fstream>
 #include <set>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace backend
 {
@@ -17,7 +19,7 @@ namespace backend
     // it is a map bewteen variable and its mem addr, the mem addr of a local variable can be identified by ($sp + off)
     struct stackVarMap
     {
-        std::map<std::string, int> _table;
+        std::unordered_map<ir::Symbol, int> _table;
 
         /**
          * @brief find the addr of a ir::Operand
@@ -35,10 +37,10 @@ namespace backend
 
     struct Generator
     {
-        const ir::Program &program;        // the program to gen
-        std::ofstream &fout;               // output file
-        stackVarMap stackVar;              // the stackVarMap of current function
-        std::set<std::string> global_vals; // the global variables
+        const ir::Program &program;                 // the program to gen
+        std::ofstream &fout;                        // output file
+        stackVarMap stackVar;                       // the stackVarMap of current function
+        std::unordered_set<ir::Symbol> global_vals; // the global variables
         std::map<int, std::string> label_map;
         int label_cnt;
 
@@ -58,6 +60,7 @@ namespace backend
         void load(ir::Operand, std::string, std::string);     // load a word from mem
         void store(ir::Operand, std::string, int offset = 0); // store a word to mem
         void store(ir::Operand, std::string, std::string);    // store a word to mem
+        void load_address(ir::Operand, std::string);          // load the address of an array
 
         std::string get_temp_reg();
         void free_temp_reg(std::string);
@@ -24,11 +24,97 @@ using ir::Type;
 #include<set>
 #include<vector>
 #include<string>
+#include<utility>
+#include<type_traits>
 using std::vector;
 using std::string;
 
 namespace frontend {
 
+// a bump-pointer arena owned by a parse session, AST nodes and their children arrays are allocated in it,
+// nodes are never deleted one by one, they are freed together with the arena
+struct AstArena {
+    static const size_t BLOCK_SIZE = 1 << 16;
+
+    /**
+     * @brief constructor, no memory is allocated until the first node
+     */
+    AstArena();
+
+    /**
+     * @brief destructor, free all nodes
+     */
+    ~AstArena();
+
+    // rejcet copy and assignment
+    AstArena(const AstArena&) = delete;
+    AstArena& operator=(const AstArena&) = delete;
+
+    /**
+     * @brief allocate raw memory from the arena
+     */
+    void* allocate(size_t size, size_t align);
+
+    /**
+     * @brief construct an AST node in the arena, its children array is also allocated in the arena
+     * @return the node, it is valid until reset() or the arena is destructed
+     */
+    template<typename T, typename... Args>
+    T* create(Args&&... args);
+
+    /**
+     * @brief free all nodes, the arena can be used again
+     */
+    void reset();
+
+    size_t node_count() const;  // number of nodes created
+    size_t bytes_used() const;  // bytes allocated by nodes and children arrays, including alignment
+
+private:
+    std::vector<char*> blocks;  // all memory of the arena
+    char* cur;                  // the next free byte of current block
+    char* end;                  // the end of current block
+    size_t nodes;
+    size_t used;
+    std::vector<std::pair<void (*)(void*), void*>> dtors;   // the nodes which have to be destructed before freed
+};
+
+// an allocator for std containers which allocates from an AstArena, memory is never given back to the arena,
+// it uses the global heap if arena is nullptr
+template<typename T>
+struct ArenaAllocator {
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    AstArena* arena;
+
+    ArenaAllocator(AstArena* a = nullptr) noexcept: arena(a) {}
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept: arena(other.arena) {}
+
+    T* allocate(size_t n) {
+        if (arena)
+            return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+    void deallocate(T* p, size_t) noexcept {
+        if (!arena)
+            ::operator delete(p);
+    }
+};
+
+template<typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) { return a.arena == b.arena; }
+template<typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) { return a.arena != b.arena; }
+
+// most nodes only hold values and arena memory, so their destructors are not called when the arena is freed,
+// a node type which owns other memory should be specialized as true
+template<typename T>
+struct arena_needs_destructor: std::false_type {};
+
 // enumerate for node type
 enum class NodeType {
     TERMINAL,       // terminal lexical unit
@@ -68,9 +154,11 @@ std::string toString(NodeType);
 
 // tree node basic class
 struct AstNode{
+    typedef std::vector<AstNode*, ArenaAllocator<AstNode*>> Children;
+
     NodeType type;  // the node type
     AstNode* parent;    // the parent node
-    vector<AstNode*> children;     // children of node
+    Children children;     // children of node, the nodes are owned by the AstArena
 
     /**
      * @brief constructor
@@ -78,7 +166,7 @@ struct AstNode{
     AstNode(NodeType t, AstNode* p = nullptr);
 
     /**
-     * @brief destructor
+     * @brief destructor, children are not deleted, they are freed with the AstArena
      */
     virtual ~AstNode();
 
@@ -146,7 +234,7 @@ struct BType: AstNode {
 };
 
 struct ConstDef: AstNode{
-    std::string arr_name;
+    ir::Symbol arr_name;
 
     /**
      * @brief constructor
@@ -155,7 +243,7 @@ struct ConstDef: AstNode{
 };
 
 struct ConstInitVal: AstNode{
-    string v;
+    ir::Symbol v;
     Type t;
 
     /**
@@ -174,7 +262,7 @@ struct VarDecl: AstNode{
 };
 
 struct VarDef: AstNode{
-    std::string arr_name;
+    ir::Symbol arr_name;
 
     /**
      * @brief constructor
@@ -184,7 +272,7 @@ struct VarDef: AstNode{
 
 struct InitVal: AstNode{
     bool is_computable = false;
-    string v;
+    ir::Symbol v;
     Type t;
 
     /**
@@ -238,10 +326,13 @@ struct Stmt: AstNode{
      */
     Stmt(AstNode* p = nullptr);
 };
+// the jump sets own heap memory
+template<>
+struct arena_needs_destructor<Stmt>: std::true_type {};
 
 struct Exp: AstNode{
     bool is_computable = false; // 节点以下子树是否可以化简为常数, 通过该变量, 大部分常数合并可以直接在语法树中自底向上进行传递
-    string v; // 一个字符串, 或者是重命名后的变量名, 或者是临时变量名称, 也可以是常数字符串
+    ir::Symbol v; // 一个字符串, 或者是重命名后的变量名, 或者是临时变量名称, 也可以是常数字符串
     Type t; // Type, 表示该表达式计算得到的类型
 
     /**
@@ -252,7 +343,7 @@ struct Exp: AstNode{
 
 struct Cond: AstNode{
     bool is_computable = false;
-    string v;
+    ir::Symbol v;
     Type t;
 
     /**
@@ -263,7 +354,7 @@ struct Cond: AstNode{
 
 struct LVal: AstNode{
     bool is_computable = false;
-    string v;
+    ir::Symbol v;
     Type t;
     int i;  // array index, legal if t is IntPtr or FloatPtr
 
@@ -275,7 +366,7 @@ struct LVal: AstNode{
 
 struct Number: AstNode{
     bool is_computable = true;
-    string v;
+    ir::Symbol v;
     Type t;
 
     /**
@@ -286,7 +377,7 @@ struct Number: AstNode{
 
 struct PrimaryExp: AstNode{
     bool is_computable = false;
-    string v;
+    ir::Symbol v;
     Type t;
     
     /**
@@ -297,7 +388,7 @@ struct PrimaryExp: AstNode{
 
 struct UnaryExp: AstNode{
     bool is_computable = false;
-    string v;
+    ir::Symbol v;
     Type t;
 
     /**
@@ -324,7 +415,7 @@ struct FuncRParams: AstNode{
 
 struct MulExp: AstNode{
     bool is_computable = false;
-    string v;
+    ir::Symbol v;
     Type t;
 
     /**
@@ -335,7 +426,7 @@ struct MulExp: AstNode{
 
 struct AddExp: AstNode{
     bool is_computable = false;
-    string v;
+    ir::Symbol v;
     Type t;
 
     /**
@@ -346,7 +437,7 @@ struct AddExp: AstNode{
 
 struct RelExp: AstNode{
     bool is_computable = false;
-    string v;
+    ir::Symbol v;
     Type t = Type::Int;
 
     /**
@@ -357,7 +448,7 @@ struct RelExp: AstNode{
 
 struct EqExp: AstNode{
     bool is_computable = false;
-    string v;
+    ir::Symbol v;
     Type t = Type::Int;
 
     /**
@@ -368,7 +459,7 @@ struct EqExp: AstNode{
 
 struct LAndExp: AstNode{
     bool is_computable = false;
-    string v;
+    ir::Symbol v;
     Type t = Type::Int;
 
     /**
@@ -379,7 +470,7 @@ struct LAndExp: AstNode{
 
 struct LOrExp: AstNode{
     bool is_computable = false;
-    string v;
+    ir::Symbol v;
     Type t = Type::Int;
 
     /**
@@ -390,7 +481,7 @@ struct LOrExp: AstNode{
 
 struct ConstExp: AstNode{
     bool is_computable = true;
-    string v;
+    ir::Symbol v;
     Type t ;
 
     /**
@@ -398,7 +489,23 @@ struct ConstExp: AstNode{
      */
     ConstExp(AstNode* p = nullptr);
 };
-    
+
+template<typename T>
+void destruct_in_arena(void* node) {
+    static_cast<T*>(node)->~T();
+}
+
+template<typename T, typename... Args>
+T* AstArena::create(Args&&... args) {
+    T* node = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    if (node->children.get_allocator().arena != this)
+        node->children = AstNode::Children(ArenaAllocator<AstNode*>(this));
+    if (arena_needs_destructor<T>::value)
+        dtors.push_back({destruct_in_arena<T>, node});
+    nodes++;
+    return node;
+}
+
 } // namespace frontend
 
 #endif
\ No newline at end of file
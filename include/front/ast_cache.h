@@ -0,0 +1,83 @@
+/**
+ * @file ast_cache.h
+ * @brief
+ * binary cache of the FlatAst, so a source file which is compiled again is not scanned or parsed again.
+ * a cache file is named by the hash of the source text, it has a versioned header and a checksum of its content,
+ * and it is mapped into memory and copied into the FlatAst arrays when loaded
+ * @version 0.1
+ * @date 2023-01-14
+ *
+ */
+
+#ifndef AST_CACHE_H
+#define AST_CACHE_H
+
+#include "front/flat_ast.h"
+
+#include <string>
+#include <cstdint>
+
+// the version of the cache file, increase it when the file format or NodeType or TokenType changes
+#define AST_CACHE_VERSION 1
+
+namespace frontend
+{
+
+    /**
+     * @brief a 64-bit hash of a byte string, used as the cache key and the checksum, it is not cryptographic
+     */
+    uint64_t hash_bytes(const char *data, size_t size, uint64_t seed = 0);
+
+    // the header at the beginning of a cache file
+    struct AstCacheHeader
+    {
+        uint32_t magic;        // AST_CACHE_MAGIC, also rejects files of another byte order
+        uint32_t version;      // AST_CACHE_VERSION
+        uint64_t source_hash;  // hash of the source text
+        uint64_t source_size;  // size of the source text
+        uint32_t node_num;     // number of nodes
+        uint32_t token_num;    // number of tokens
+        uint32_t text_size;    // bytes of all token texts
+        uint32_t reserved;     // 0
+        uint64_t checksum;     // hash of the content after the header
+    };
+
+    // the cache of a source file in a directory
+    struct AstCache
+    {
+        /**
+         * @brief constructor, hash the source file
+         * @param dir: the directory of cache files, it should exist
+         * @param filename: the source file
+         */
+        AstCache(const std::string &dir, const std::string &filename);
+
+        /**
+         * @brief the path of the cache file
+         */
+        const std::string &get_path() const;
+
+        /**
+         * @brief load the AST of the source file
+         * @param[out] ast: an empty FlatAst
+         * @return false if there is no valid cache file for the source text, ast is left empty
+         */
+        bool load(FlatAst &ast) const;
+
+        /**
+         * @brief save the AST of the source file, the file is written to a temporary file and renamed,
+         * so other compilers never see a half written cache file
+         * @return false if the file can not be written
+         */
+        bool save(const FlatAst &ast) const;
+
+    private:
+        std::string path;      // dir/<source hash>.ast
+        uint64_t source_hash;  // hash of the source text
+        uint64_t source_size;  // size of the source text
+        bool valid;            // false if the source file can not be opened
+    };
+
+} // namespace frontend
+
+#endif
@@ -0,0 +1,90 @@
+/**
+ * @file const_value.h
+ * @brief
+ * a compile-time constant of SysY, an int or a float, it is carried on the AST nodes while folding,
+ * so a folded value is never written into text and read back.
+ * int is 32-bit two's complement and wraps on overflow, float is single precision
+ * @version 0.1
+ * @date 2023-01-16
+ *
+ */
+
+#ifndef CONST_VALUE_H
+#define CONST_VALUE_H
+
+#include "front/token.h"
+#include "ir/ir_operand.h"
+
+#include <cstdint>
+
+namespace frontend
+{
+
+    struct ConstValue
+    {
+        ir::Type t; // IntLiteral or FloatLiteral
+        union
+        {
+            int32_t i;
+            float f;
+        };
+
+        /**
+         * @brief constructor, int 0
+         */
+        ConstValue();
+
+        static ConstValue of_int(int32_t v);
+        static ConstValue of_float(float v);
+
+        /**
+         * @brief the value of an IntConst or a floatConst token, an IntConst may be decimal, octal, hex or binary
+         */
+        static ConstValue of_token(const Token &token);
+
+        /**
+         * @brief the value of an operand whose type is IntLiteral or FloatLiteral
+         */
+        static ConstValue of_operand(const ir::Operand &op);
+
+        static bool is_literal(ir::Type type) { return type == ir::Type::IntLiteral || type == ir::Type::FloatLiteral; }
+
+        bool is_float() const { return t == ir::Type::FloatLiteral; }
+        int32_t to_int() const;   // a float is truncated toward zero
+        float to_float() const;
+
+        /**
+         * @brief convert to type, IntLiteral or FloatLiteral
+         */
+        ConstValue cast(ir::Type type) const;
+
+        /**
+         * @brief the 32 bits in memory, the two's complement of an int or the IEEE 754 bits of a float
+         */
+        uint32_t bits() const;
+
+        /**
+         * @brief true for int 0 and float +0.0
+         */
+        bool is_zero() const;
+
+        /**
+         * @brief the literal operand name in IR, its text is made when the IR is printed
+         */
+        ir::Symbol to_symbol() const;
+    };
+
+    /**
+     * @brief fold a binary operator, if one of a and b is a float, the other is converted to float,
+     * the result of '<' '<=' '>' '>=' '==' '!=' '&&' '||' is an int
+     */
+    ConstValue fold_binary(TokenType op, ConstValue a, ConstValue b);
+
+    /**
+     * @brief fold an unary operator, '+' '-' or '!'
+     */
+    ConstValue fold_unary(TokenType op, ConstValue a);
+
+} // namespace frontend
+
+#endif
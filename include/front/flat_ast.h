@@ -0,0 +1,206 @@
+/**
+ * @file flat_ast.h
+ * @brief
+ * a compact AST, the nodes are numbered and their fields are stored in arrays instead of objects.
+ * the children of a node have consecutive numbers, so the i-th child of a node is first_child + i,
+ * and a node costs about 26 bytes instead of a heap object with a vtable and a children vector.
+ * the Analyzer walks the FlatAst through FlatNode, which looks like a pointer to an AST node
+ * @version 0.1
+ * @date 2023-01-13
+ *
+ */
+
+#ifndef FLAT_AST_H
+#define FLAT_AST_H
+
+#include "front/abstract_syntax_tree.h"
+#include "front/token.h"
+#include "front/const_value.h"
+#include "json/json.h"
+#include "ir/ir.h"
+
+#include <vector>
+#include <ostream>
+#include <cstdint>
+
+namespace frontend
+{
+
+    typedef uint32_t NodeId;
+
+    struct FlatNode;
+
+    // the AST in arrays, node 0 is the root CompUnit
+    struct FlatAst
+    {
+        static const NodeId NONE = UINT32_MAX;
+
+        std::vector<uint8_t> kind;            // NodeType of the node
+        std::vector<uint32_t> token;          // index in tokens for TERMINAL, NONE for others
+        std::vector<NodeId> first_child;      // NONE if the node has no child
+        std::vector<NodeId> next_sibling;     // NONE for the last child
+        std::vector<uint32_t> child_count;    // number of children
+        std::vector<ir::Symbol> v;            // value of expressions, arr_name of ConstDef and VarDef, n of FuncDef
+        std::vector<ir::Type> t;              // type of expressions and FuncDef
+        std::vector<uint8_t> is_computable;   // 节点以下子树是否可以化简为常数
+        std::vector<ConstValue> c;            // value of expressions whose t is IntLiteral or FloatLiteral
+        std::vector<Token> tokens;            // tokens of TERMINAL nodes
+
+        /**
+         * @brief constructor, an empty AST, use add_node() or Parser::get_flat_abstract_syntax_tree() to fill it
+         */
+        FlatAst();
+
+        /**
+         * @brief constructor, copy an AST made of AstNode
+         * @param root: the root of the AST
+         */
+        explicit FlatAst(const CompUnit *root);
+
+        /**
+         * @brief add a node without children
+         * @return the id of the node
+         */
+        NodeId add_node(NodeType type);
+
+        /**
+         * @brief add n children to a node which has no child, their ids are consecutive
+         * @return the id of the first child, the children are TERMINAL until set_type() is called
+         */
+        NodeId add_children(NodeId parent, uint32_t n);
+
+        /**
+         * @brief set the type of a node, is_computable is set to the default of the type
+         */
+        void set_type(NodeId id, NodeType type);
+
+        /**
+         * @brief resize v, t, is_computable and c to the number of nodes, and set them to the defaults of the node types,
+         * it is used after kind is filled directly, such as by AstCache
+         */
+        void reset_attributes();
+
+        /**
+         * @brief copy an AstNode and its subtree to node id, which is already added with the same type
+         */
+        void copy_subtree(const AstNode *node, NodeId id);
+
+        /**
+         * @brief add nodes without children until there are node_num nodes, and empty tokens until there are token_num tokens,
+         * the new nodes are TERMINAL until set_type() or copy_part() is called
+         */
+        void resize(size_t node_num, size_t token_num);
+
+        /**
+         * @brief copy another FlatAst into nodes which are already added, the root of part is copied to node id,
+         * and node k of part is copied to node base + k - 1, token k of part is copied to token token_base + k.
+         * the next_sibling of node id is not changed.
+         * different parts can be copied by different threads at the same time
+         */
+        void copy_part(NodeId id, NodeId base, uint32_t token_base, const FlatAst &part);
+
+        size_t size() const;        // number of nodes
+        size_t bytes_used() const;  // bytes used by the arrays, including tokens
+
+        NodeType type_of(NodeId id) const;
+        const Token &token_of(NodeId id) const;  // an empty token if the node is not a TERMINAL
+
+        /**
+         * @brief a handle of node id, it is valid until more nodes are added
+         */
+        FlatNode get_node(NodeId id);
+
+        /**
+         * @brief Get the json output object, the same as AstNode::get_json_output()
+         * @param root: a Json::Value buffer, should be initialized before calling this function
+         */
+        void get_json_output(Json::Value &root, NodeId id = 0) const;
+
+        /**
+         * @brief write the AST as json, the text is the same as Json::StyledWriter writes for get_json_output(),
+         * but no Json::Value is built, the text is written to out through a small buffer
+         */
+        void write_json(std::ostream &out) const;
+    };
+
+    // the children of a FlatNode, children[i] is the id of the i-th child
+    struct FlatChildren
+    {
+        NodeId first;
+        uint32_t count;
+
+        size_t size() const { return count; }
+        NodeId operator[](size_t i) const { return first + (NodeId)i; }
+    };
+
+    // a node of FlatAst, it is used like a pointer to the AstNode sub-class, such as node->v and node->children[i],
+    // the fields refer to the arrays of FlatAst
+    struct FlatNode
+    {
+        NodeId id;
+        NodeType type;
+        FlatChildren children;
+        ir::Symbol &v;            // Exp and other expressions
+        ir::Symbol &arr_name;     // ConstDef and VarDef, the same field as v
+        ir::Symbol &n;            // FuncDef, the same field as v
+        ir::Type &t;
+        uint8_t &is_computable;
+        ConstValue &c;            // expressions whose t is a literal type
+        const Token &token;       // Term
+        TokenType op;             // UnaryOp, the type of its Term
+
+        /**
+         * @brief constructor
+         */
+        FlatNode(FlatAst &ast, NodeId id);
+
+        FlatNode *operator->() { return this; }
+    };
+
+    // the NodeType of an AstNode sub-class, used to check a FlatNode like dynamic_cast
+    template <typename T>
+    struct flat_node_type;
+
+#define FLAT_NODE_TYPE(cls, node_type)                                \
+    template <>                                                        \
+    struct flat_node_type<cls>                                         \
+    {                                                                  \
+        static const NodeType value = NodeType::node_type;             \
+    };
+    FLAT_NODE_TYPE(Term, TERMINAL)
+    FLAT_NODE_TYPE(CompUnit, COMPUINT)
+    FLAT_NODE_TYPE(Decl, DECL)
+    FLAT_NODE_TYPE(FuncDef, FUNCDEF)
+    FLAT_NODE_TYPE(ConstDecl, CONSTDECL)
+    FLAT_NODE_TYPE(BType, BTYPE)
+    FLAT_NODE_TYPE(ConstDef, CONSTDEF)
+    FLAT_NODE_TYPE(ConstInitVal, CONSTINITVAL)
+    FLAT_NODE_TYPE(VarDecl, VARDECL)
+    FLAT_NODE_TYPE(VarDef, VARDEF)
+    FLAT_NODE_TYPE(InitVal, INITVAL)
+    FLAT_NODE_TYPE(FuncType, FUNCTYPE)
+    FLAT_NODE_TYPE(FuncFParam, FUNCFPARAM)
+    FLAT_NODE_TYPE(FuncFParams, FUNCFPARAMS)
+    FLAT_NODE_TYPE(Block, BLOCK)
+    FLAT_NODE_TYPE(BlockItem, BLOCKITEM)
+    FLAT_NODE_TYPE(Stmt, STMT)
+    FLAT_NODE_TYPE(Exp, EXP)
+    FLAT_NODE_TYPE(Cond, COND)
+    FLAT_NODE_TYPE(LVal, LVAL)
+    FLAT_NODE_TYPE(Number, NUMBER)
+    FLAT_NODE_TYPE(PrimaryExp, PRIMARYEXP)
+    FLAT_NODE_TYPE(UnaryExp, UNARYEXP)
+    FLAT_NODE_TYPE(UnaryOp, UNARYOP)
+    FLAT_NODE_TYPE(FuncRParams, FUNCRPARAMS)
+    FLAT_NODE_TYPE(MulExp, MULEXP)
+    FLAT_NODE_TYPE(AddExp, ADDEXP)
+    FLAT_NODE_TYPE(RelExp, RELEXP)
+    FLAT_NODE_TYPE(EqExp, EQEXP)
+    FLAT_NODE_TYPE(LAndExp, LANDEXP)
+    FLAT_NODE_TYPE(LOrExp, LOREXP)
+    FLAT_NODE_TYPE(ConstExp, CONSTEXP)
+#undef FLAT_NODE_TYPE
+
+} // namespace frontend
+
+#endif
@@ -0,0 +1,115 @@
+/**
+ * @file incremental.h
+ * @brief
+ * incremental frontend for editors, which check the source again after every keystroke.
+ * an edit replaces a range of the source text, only the tokens around the range are scanned again, and only
+ * the top-level Decl or FuncDef which contain the changed tokens are parsed again, the other top-level nodes of
+ * the AST are kept as they are
+ * @version 0.1
+ * @date 2023-01-12
+ *
+ */
+
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include "front/abstract_syntax_tree.h"
+#include "front/lexical.h"
+#include "front/token.h"
+
+#include <vector>
+#include <string>
+
+namespace frontend
+{
+
+    // what an edit costs, and what it would cost to rebuild from scratch
+    struct EditReport
+    {
+        uint32_t relexed_tokens;  // number of tokens scanned again
+        uint32_t reparsed_items;  // number of top-level Decl or FuncDef parsed again
+        bool full_rebuild;        // true if the edit can not be handled incrementally
+        double incremental_ms;    // time used by the edit
+        double full_ms;           // time used by the last full rebuild
+
+        /**
+         * @brief the time saved against a full rebuild, in ms
+         */
+        double saved_ms() const;
+
+        /**
+         * @brief a line of text for log
+         */
+        std::string to_string() const;
+    };
+
+    // the source text of a file and its tokens and AST, which are updated by every edit
+    struct IncrementalFrontend
+    {
+        /**
+         * @brief constructor, scan and parse the whole text
+         * @param text: the source text
+         */
+        IncrementalFrontend(const std::string &text);
+
+        /**
+         * @brief destructor, the AST is freed
+         */
+        ~IncrementalFrontend();
+
+        // rejcet copy and assignment
+        IncrementalFrontend(const IncrementalFrontend &) = delete;
+        IncrementalFrontend &operator=(const IncrementalFrontend &) = delete;
+
+        /**
+         * @brief replace [begin, end) of the source text with text, then update the tokens and AST
+         * @return EditReport: what is done for the edit
+         */
+        EditReport apply_edit(uint32_t begin, uint32_t end, const std::string &text);
+
+        /**
+         * @brief the root of AST, it is owned by IncrementalFrontend and may change after apply_edit()
+         */
+        CompUnit *get_abstract_syntax_tree() const;
+
+        /**
+         * @brief the tokens of current source text, they refer to get_source()
+         */
+        const std::vector<TokenView> &get_tokens() const;
+
+        /**
+         * @brief current source text
+         */
+        const std::string &get_source() const;
+
+    private:
+        std::string source;                // current source text
+        std::vector<TokenView> tokens;     // tokens of source
+        AstArena arena;                    // the AST nodes, replaced nodes are kept in it until next full rebuild
+        size_t rebuild_bytes;              // bytes used by arena after last full rebuild
+        std::vector<CompUnit *> units;     // the CompUnit chain, units[0] is the root, units[i] holds items[i] and units[i + 1]
+        std::vector<AstNode *> items;      // top-level Decl and FuncDef
+        std::vector<uint32_t> item_begin;  // the first token of items[i], item_begin[items.size()] is the end of the last item
+        double full_ms;                    // time used by the last full rebuild
+
+        /**
+         * @brief scan and parse the whole source text
+         */
+        void rebuild();
+
+        /**
+         * @brief parse tokens [begin, end) as a CompUnit
+         * @param[out] parsed: the top-level Decl and FuncDef
+         * @return false if the tokens are not exactly a CompUnit
+         */
+        bool parse_items(uint32_t begin, uint32_t end, std::vector<AstNode *> &parsed);
+
+        /**
+         * @brief link units from position from, every unit holds its item and the next unit
+         */
+        void relink(uint32_t from);
+    };
+
+} // namespace frontend
+
+#endif
@@ -63,22 +63,99 @@ namespace frontend
 
         /**
          * @brief take a char as input, change state to next state, and output a Token if necessary
+         * the next state is looked up in a transition table which is built at compile time
          * @param[in] input: the input character
          * @param[out] buf: the output Token buffer
          * @return  return true if a Token is produced, the buf is valid then
          */
         bool next(char input, Token &buf);
 
+        /**
+         * @brief same as next(char, Token&), but the input is src[pos] and the characters are not copied,
+         * the output TokenView refers to src. the characters of current token should be kept in src, so
+         * positions should be given in ascending order
+         * @param[in] src: the source buffer
+         * @param[in] pos: the position of the input character in src
+         * @param[out] buf: the output TokenView buffer
+         * @return  return true if a Token is produced, the buf is valid then
+         */
+        bool next(const char *src, uint32_t pos, TokenView &buf);
+
+        /**
+         * @brief end the current token as if a space is read at src[end], used at the end of input or before a comment
+         * @return  return true if a Token is produced, the buf is valid then
+         */
+        bool finish(const char *src, uint32_t end, TokenView &buf);
+
         /**
          * @brief reset the DFA state to begin
          */
         void reset();
 
+        /**
+         * @brief get current state, the scanner uses it to skip characters which do not change the state
+         */
+        State get_state() const;
+
     private:
-        State cur_state;     // record current state of the DFA
-        std::string cur_str; // record input characters
+        uint8_t cur_state;   // record current state of the DFA, it is a row of the transition table in lexical.cpp
+        std::string cur_str; // record input characters, only used by next(char, Token&)
+        uint32_t cur_begin;  // the position where current token begins
+
+        /**
+         * @brief get the type of current token, which is [str, str + len)
+         */
+        TokenType get_token_type(const char *str, uint32_t len) const;
     };
 
+    // the whole input file in memory, it is mapped by mmap if possible, so tokens can refer to it instead of copying
+    struct SourceBuffer
+    {
+        /**
+         * @brief constructor, the buffer is empty until open() is called
+         */
+        SourceBuffer();
+
+        /**
+         * @brief destructor, unmap the file
+         */
+        ~SourceBuffer();
+
+        // rejcet copy and assignment
+        SourceBuffer(const SourceBuffer &) = delete;
+        SourceBuffer &operator=(const SourceBuffer &) = delete;
+
+        /**
+         * @brief map the whole file into memory, read it into a heap buffer if mmap is not supported
+         * @param[in] filename: the input file
+         * @return true if the file is opened
+         */
+        bool open(const std::string &filename);
+
+        /**
+         * @brief unmap the file, every TokenView refers to this buffer becomes invalid
+         */
+        void close();
+
+        const char *data() const;
+        size_t size() const;
+
+    private:
+        const char *buf; // the file content, not '\0' terminated
+        size_t len;      // the file size
+        bool mapped;     // true if buf is mapped by mmap, else it is allocated by new[]
+    };
+
+    /**
+     * @brief scan src[pos, end) until a token is produced, besides the DFA, the only state of scanning is whether
+     * it is inside a block comment, so a text can be scanned in several ranges split at '\n' or at the end of a token
+     * @param[in,out] pos: the position of next character to be scanned
+     * @param[in,out] in_comment: true if pos is inside a block comment
+     * @param[out] buf: the output TokenView buffer, it refers to src
+     * @return false if it reaches end, the last token of the text should be flushed by dfa.finish() then
+     */
+    bool scan_token(const char *src, uint32_t end, uint32_t &pos, bool &in_comment, DFA &dfa, TokenView &buf);
+
     // definition of Scanner
     struct Scanner
     {
@@ -103,8 +180,103 @@ namespace frontend
          */
         std::vector<Token> run();
 
+        /**
+         * @brief run the scanner on the memory mapped input file, no string is allocated for lines or tokens,
+         * comments are treated as spaces
+         * @return std::vector<TokenView>: the result token stream, it refers to get_source() and is valid as long as the Scanner is alive
+         */
+        std::vector<TokenView> run_mapped();
+
+        /**
+         * @brief scan the next token from the memory mapped input file, run_mapped() is a loop of it,
+         * so the whole token stream needs not to be kept in memory
+         * @param[out] buf: the output TokenView buffer, it refers to get_source()
+         * @return false if there is no more token
+         */
+        bool next_token(TokenView &buf);
+
+        /**
+         * @brief scan the memory mapped input file with several threads, the file is split into chunks at '\n',
+         * and the chunks which begin inside a block comment are scanned again in order
+         * @param thread_num: the number of threads, including the calling thread
+         * @return std::vector<TokenView>: the same token stream as run_mapped()
+         */
+        std::vector<TokenView> run_parallel(uint32_t thread_num);
+
+        /**
+         * @brief the size of the input file, the file is mapped if it is not mapped yet
+         */
+        size_t get_source_size();
+
+        /**
+         * @brief get the source buffer used by run_mapped()
+         */
+        const SourceBuffer &get_source() const;
+
+        /**
+         * @brief copy the text of a TokenView produced by run_mapped() or next_token()
+         */
+        std::string get_text(const TokenView &) const;
+
     private:
-        std::ifstream fin; // the input file
+        std::ifstream fin;     // the input file
+        std::string filename;  // the input file name
+        SourceBuffer source;   // the input file in memory, only valid after run_mapped()
+        DFA dfa;               // the DFA used by next_token()
+        uint32_t cursor;       // the position of next character to be scanned by next_token()
+        bool finished;         // true if the last token has been flushed by next_token()
+        bool in_comment;       // true if next_token() stops inside a block comment
+
+        /**
+         * @brief map the input file if it is not mapped yet
+         */
+        void open_source();
+    };
+
+    // a token stream which is pulled from a Scanner lazily, it keeps only a small lookahead window,
+    // so lexing and parsing are done in one pass
+    struct TokenStream
+    {
+        static const uint32_t LOOKAHEAD = 4; // the size of ring buffer, must be power of 2
+
+        /**
+         * @brief constructor, the tokens are scanned by scanner.next_token() when they are looked at
+         */
+        TokenStream(Scanner &scanner);
+
+        /**
+         * @brief constructor, the tokens are read from a vector which is already scanned
+         */
+        TokenStream(const std::vector<Token> &tokens);
+
+        // rejcet copy and assignment
+        TokenStream(const TokenStream &) = delete;
+        TokenStream &operator=(const TokenStream &) = delete;
+
+        /**
+         * @brief look at the k-th token after current one without consuming it
+         * @param k: 0 is current token, should be less than LOOKAHEAD
+         * @return the token, its type is TokenType::ENDTK if the stream ends
+         */
+        const Token &peek(uint32_t k = 0);
+
+        /**
+         * @brief consume current token
+         */
+        void advance();
+
+    private:
+        Scanner *scanner;                 // the lazy source, nullptr if tokens are read from vector
+        const std::vector<Token> *tokens; // the vector source
+        uint32_t vector_index;            // the next token to read from vector
+        Token window[LOOKAHEAD];          // ring buffer of tokens which are looked at but not consumed
+        uint32_t head;                    // current token is window[head]
+        uint32_t count;                   // number of tokens in window
+
+        /**
+         * @brief read a token from the source to the end of window
+         */
+        void fill();
     };
 
 } // namespace frontend
@@ -0,0 +1,48 @@
+/**
+ * @file lexical_simd.h
+ * @brief
+ * the fast paths of Scanner::run_mapped
+ * most bytes in a source file are spaces, comments or the middle of identifiers and numbers, they never change the
+ * state of DFA, so the scanner skips them 16 or 32 bytes at a time and only gives the token boundaries to DFA.
+ * the kernels are implemented with SSE2 and AVX2, and the best one supported by the CPU is chosen at runtime,
+ * a scalar version is used on other platforms
+ * @version 0.1
+ * @date 2023-01-05
+ *
+ */
+
+#ifndef LEXICAL_SIMD_H
+#define LEXICAL_SIMD_H
+
+#include <cstdint>
+
+namespace frontend
+{
+
+    // every kernel scans [src + pos, src + end) and returns the first position which does not satisfy it, or end
+    struct ScanKernels
+    {
+        const char *name; // "avx2", "sse2" or "scalar"
+
+        // skip ' ', '\t', '\n', '\r'
+        uint32_t (*skip_space)(const char *src, uint32_t pos, uint32_t end);
+
+        // skip [a-zA-Z0-9_], the rest of an identifier
+        uint32_t (*skip_ident)(const char *src, uint32_t pos, uint32_t end);
+
+        // skip [a-zA-Z0-9], the rest of a number, like '1900', '0x1f' or '0.5'
+        uint32_t (*skip_alnum)(const char *src, uint32_t pos, uint32_t end);
+
+        // find the character c
+        uint32_t (*find_char)(const char *src, uint32_t pos, uint32_t end, char c);
+    };
+
+    /**
+     * @brief get the kernels for current CPU, it is decided at the first call
+     * define DEBUG_SCAN_SCALAR to always use the scalar version
+     */
+    const ScanKernels &get_scan_kernels();
+
+} // namespace frontend
+
+#endif
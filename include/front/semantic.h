@@ -15,8 +15,10 @@
 
 #include "ir/ir.h"
 #include "front/abstract_syntax_tree.h"
+#include "front/flat_ast.h"
 
 #include <map>
+#include <unordered_map>
 #include <string>
 #include <vector>
 using std::map;
@@ -31,33 +33,40 @@ namespace frontend
     {
         ir::Operand operand;   // 符号的名字和类型
         vector<int> dimension; // for数组
+        ConstValue value;      // 常量的值, operand 的类型是 IntLiteral 或 FloatLiteral 时有效
     };
 
-    using map_str_ste = map<string, STE>; // string 是操作数的原始名称
-    // 作用域
-    struct ScopeInfo
+    // 符号表中的一次声明, 同名的声明按作用域由内向外串成一条链
+    struct SymbolBinding
     {
-        int cnt;           // 作用域在函数中的唯一编号, 代表是函数中出现的第几个作用域
-        string name;       // 分辨作用域的类别, 'b' 代表是一个单独嵌套的作用域, 'i' 'e' 'w' 分别代表由 if else while 产生的新作用域
-        map_str_ste table; // 一张存放符号的表
+        ir::Symbol id;     // 操作数的原始名称
+        STE ste;
+        uint32_t shadowed; // 被这次声明遮住的同名声明在 bindings 中的下标, 没有则为 NONE
+        uint32_t depth;    // 声明所在作用域的层数, 最外层为 1
     };
 
     // surpport lib functions
-    map<std::string, ir::Function *> *get_lib_funcs();
+    std::unordered_map<ir::Symbol, ir::Function *> *get_lib_funcs();
 
-    // 符号表，栈式结构
+    // 符号表, 所有作用域共用一张哈希表, 表中是每个名字最内层的声明, 查找不随嵌套层数变慢
+    // bindings 按声明顺序存放, 同时是退出作用域时的撤销日志
     struct SymbolTable
     {
-        vector<ScopeInfo> scope_stack;
-        map<std::string, ir::Function *> functions;
+        static const uint32_t NONE = UINT32_MAX;
+
+        std::unordered_map<ir::Symbol, uint32_t> table; // 名字 -> 最内层声明在 bindings 中的下标
+        vector<SymbolBinding> bindings;                  // 所有作用域中的声明, 内层作用域的在后面
+        vector<uint32_t> scope_begin;                    // 每个作用域的第一个声明在 bindings 中的下标
+        mutable std::unordered_map<uint64_t, ir::Symbol> scoped_names; // (名字, 层数) -> 重命名后的名字
+        std::unordered_map<ir::Symbol, ir::Function *> functions;
 
         /**
-         * @brief 进入新作用域时, 向符号表中添加 ScopeInfo, 相当于压栈
+         * @brief 进入新作用域时, 记录它的第一个声明的位置, 相当于压栈
          */
         void add_scope();
 
         /**
-         * @brief 退出时弹栈
+         * @brief 退出时按撤销日志删除这个作用域的声明, 恢复被它们遮住的声明
          */
         void exit_scope();
 
@@ -74,23 +83,31 @@ namespace frontend
          * @param id: origin id
          * @return string: new name with scope infomations
          */
-        string get_scoped_name(string id) const;
+        ir::Symbol get_scoped_name(ir::Symbol id) const;
 
         /**
          * @brief 输入一个变量名, 在符号表中寻找最近的同名变量, 返回对应的 Operand(注意，此 Operand 的 name 是重命名后的)
          * @param id identifier name 标识符名称
          * @return Operand
          */
-        ir::Operand get_operand(string id) const;
+        ir::Operand get_operand(ir::Symbol id) const;
 
         /**
          * @brief  输入一个变量名, 在符号表中寻找最近的同名变量, 返回 STE
          * @param id identifier name
          * @return STE
          */
-        STE get_ste(string id) const;
+        STE get_ste(ir::Symbol id) const;
+
+        /**
+         * @brief 在当前作用域中声明一个变量, 同一作用域中的同名变量被覆盖
+         */
+        void add_operand(ir::Symbol name, STE ste);
 
-        void add_operand(std::string name, STE ste);
+        /**
+         * @brief 当前作用域中的声明, 返回 [begin, end) 两个在 bindings 中的下标
+         */
+        std::pair<uint32_t, uint32_t> current_scope() const;
     };
 
     // singleton class
@@ -98,7 +115,10 @@ namespace frontend
     {
         int tmp_cnt;
         vector<ir::Instruction *> g_init_inst;
+        std::unordered_map<ir::Symbol, vector<uint32_t>> g_init_val; // 全局变量的静态初始值, 见 ir::GlobalVal::init
+        vector<ir::GlobalVal> const_blocks;                          // 局部数组的常量初始值, copy 指令从这里复制
         SymbolTable symbol_table;
+        FlatAst *ast; // the AST being analysed
 
         /**
          * @brief constructor
@@ -106,6 +126,11 @@ namespace frontend
         Analyzer();
 
         // analysis functions
+        ir::Program get_ir_program(FlatAst &);
+
+        /**
+         * @brief copy the AST to a FlatAst, then analysis it
+         */
         ir::Program get_ir_program(CompUnit *);
 
         // reject copy & assignment
@@ -113,50 +138,64 @@ namespace frontend
         Analyzer &operator=(const Analyzer &) = delete;
 
         // ir::Operand get_temp(ir::Type);
-        std::string get_temp_name();
+        ir::Symbol get_temp_name();
         void delete_temp_name();
 
+        /**
+         * @brief if g_init_inst[begin:] only writes literals into global variables, move the values into g_init_val
+         * and remove these instructions, so the globals are initialized statically instead of in _global
+         */
+        void fold_global_init(size_t begin);
+
+        /**
+         * @brief initialize array arr of size elements, instructions[begin:] store its initial values.
+         * if they only store literals, they are replaced by a copy from a constant block, and the rest is filled with 0,
+         * else a fill of the whole array is added before them
+         */
+        void init_array(ir::Operand arr, int size, size_t begin, vector<ir::Instruction *> &instructions);
+
         // analysis functions
-        void analysisCompUnit(CompUnit *);
-
-        void analysisDecl(Decl *, vector<ir::Instruction *> &);
-        void analysisConstDecl(ConstDecl *, vector<ir::Instruction *> &);
-        void analysisConstDef(ConstDef *, vector<ir::Instruction *> &, ir::Type);
-
-        void analysisFuncDef(FuncDef *);
-        void analysisFuncType(FuncType *, ir::Type &);
-        void analysisFuncFParams(FuncFParams *, vector<ir::Operand> &);
-        void analysisFuncFParam(FuncFParam *, vector<ir::Operand> &); // TODO
-
-        void analysisBlock(Block *, vector<ir::Instruction *> &);
-        void analysisBlockItem(BlockItem *, vector<ir::Instruction *> &);
-
-        void analysisStmt(Stmt *, vector<ir::Instruction *> &);
-        void analysisExp(Exp *, vector<ir::Instruction *> &);
-
-        void analysisAddExp(AddExp *, vector<ir::Instruction *> &);
-        void analysisMulExp(MulExp *, vector<ir::Instruction *> &);
-        void analysisUnaryExp(UnaryExp *, vector<ir::Instruction *> &);
-        void analysisUnaryOp(UnaryOp *, vector<ir::Instruction *> &);
-        void analysisFuncRParams(FuncRParams *, vector<ir::Operand> &, vector<ir::Instruction *> &);
-        void analysisPrimaryExp(PrimaryExp *, vector<ir::Instruction *> &);
-        void analysisNumber(Number *, vector<ir::Instruction *> &);
-        void analysisLVal(LVal *, vector<ir::Instruction *> &, bool);
-
-        void analysisCond(Cond *, vector<ir::Instruction *> &);
-        void analysisLOrExp(LOrExp *, vector<ir::Instruction *> &);
-        void analysisLAndExp(LAndExp *, vector<ir::Instruction *> &);
-        void analysisEqExp(EqExp *, vector<ir::Instruction *> &);
-        void analysisRelExp(RelExp *, vector<ir::Instruction *> &);
-
-        void analysisConstDef(ConstDef *, vector<ir::Instruction *> &);
-        void analysisConstInitVal(ConstInitVal *, vector<ir::Instruction *> &);
-
-        void analysisVarDecl(VarDecl *, vector<ir::Instruction *> &);
-        void analysisBType(BType *);
-        void analysisVarDef(VarDef *, vector<ir::Instruction *> &, ir::Type);
-        void analysisConstExp(ConstExp *, vector<ir::Instruction *> &);
-        void analysisInitVal(InitVal *, vector<ir::Instruction *> &);
+        void analysisCompUnit(FlatNode);
+
+        void analysisDecl(FlatNode, vector<ir::Instruction *> &);
+        void analysisConstDecl(FlatNode, vector<ir::Instruction *> &);
+        void analysisConstDef(FlatNode, vector<ir::Instruction *> &, ir::Type);
+
+        void analysisFuncDef(FlatNode);
+        void analysisFuncType(FlatNode, ir::Type &);
+        void analysisFuncFParams(FlatNode, vector<ir::Operand> &);
+        void analysisFuncFParam(FlatNode, vector<ir::Operand> &); // TODO
+
+        void analysisBlock(FlatNode, vector<ir::Instruction *> &);
+        void analysisBlockItem(FlatNode, vector<ir::Instruction *> &);
+
+        void analysisStmt(FlatNode, vector<ir::Instruction *> &);
+        void analysisExp(FlatNode, vector<ir::Instruction *> &);
+
+        void analysisAddExp(FlatNode, vector<ir::Instruction *> &);
+        void analysisMulExp(FlatNode, vector<ir::Instruction *> &);
+        void analysisUnaryExp(FlatNode, vector<ir::Instruction *> &);
+        void analysisUnaryOp(FlatNode, vector<ir::Instruction *> &);
+        void analysisFuncRParams(FlatNode, vector<ir::Operand> &, vector<ir::Instruction *> &);
+        void analysisPrimaryExp(FlatNode, vector<ir::Instruction *> &);
+        void analysisNumber(FlatNode, vector<ir::Instruction *> &);
+        void analysisLVal(FlatNode, vector<ir::Instruction *> &, bool);
+
+        // Cond 生成为跳转, vector<size_t> 是待回填的跳转指令的下标
+        void analysisCond(FlatNode, vector<ir::Instruction *> &, vector<size_t> &);
+        void analysisLOrExp(FlatNode, vector<ir::Instruction *> &, vector<size_t> &, vector<size_t> &);
+        bool analysisLAndExp(FlatNode, vector<ir::Instruction *> &, bool, vector<size_t> &, vector<size_t> &);
+        void analysisEqExp(FlatNode, vector<ir::Instruction *> &);
+        void analysisRelExp(FlatNode, vector<ir::Instruction *> &);
+
+        void analysisConstDef(FlatNode, vector<ir::Instruction *> &);
+        void analysisConstInitVal(FlatNode, vector<ir::Instruction *> &);
+
+        void analysisVarDecl(FlatNode, vector<ir::Instruction *> &);
+        void analysisBType(FlatNode);
+        void analysisVarDef(FlatNode, vector<ir::Instruction *> &, ir::Type);
+        void analysisConstExp(FlatNode, vector<ir::Instruction *> &);
+        void analysisInitVal(FlatNode, vector<ir::Instruction *> &);
     };
 
 } // namespace frontend
@@ -15,6 +15,8 @@
 #define SYNTAX_H
 
 #include "front/abstract_syntax_tree.h"
+#include "front/flat_ast.h"
+#include "front/lexical.h"
 #include "front/token.h"
 
 #include <vector>
@@ -61,17 +63,26 @@ namespace frontend
     // a parser should take a token stream as input, then parsing it, output a AST
     struct Parser
     {
-        uint32_t index; // current token index
-        const std::vector<Token> &token_stream;
+        TokenStream token_stream; // current token is token_stream.peek()
+        AstArena own_arena;       // used if no arena is given
+        AstArena *arena;          // the AST nodes are created in it
 
         /**
          * @brief constructor
          * @param tokens: the input token_stream
+         * @param arena: the arena which owns the AST, if it is nullptr, the AST is owned by the Parser
          */
-        Parser(const std::vector<Token> &tokens);
+        Parser(const std::vector<Token> &tokens, AstArena *arena = nullptr);
 
         /**
-         * @brief destructor
+         * @brief constructor, tokens are pulled from the scanner while parsing, so the token stream is never stored
+         * @param scanner: the input scanner
+         * @param arena: the arena which owns the AST, if it is nullptr, the AST is owned by the Parser
+         */
+        Parser(Scanner &scanner, AstArena *arena = nullptr);
+
+        /**
+         * @brief destructor, the AST is freed if it is owned by the Parser
          */
         ~Parser();
 
@@ -81,6 +92,13 @@ namespace frontend
          */
         CompUnit *get_abstract_syntax_tree();
 
+        /**
+         * @brief creat the abstract syntax tree as a FlatAst, every top-level Decl or FuncDef is parsed into a
+         * scratch arena and copied into ast, so only one of them is kept as AstNode at a time
+         * @param[out] ast: an empty FlatAst
+         */
+        void get_flat_abstract_syntax_tree(FlatAst &ast);
+
         Term *parseTerm(AstNode *parent, TokenType expected);
 
         bool parseCompUnit(CompUnit *root);
@@ -121,6 +139,20 @@ namespace frontend
         void log(AstNode *node);
     };
 
+    // files smaller than it are parsed by one thread, the threads cost more than they save
+    const size_t PARALLEL_PARSE_MIN_SIZE = 1 << 18;
+
+    /**
+     * @brief parse the input file into ast with several threads.
+     * the tokens are pre-scanned to find every top-level Decl and FuncDef, a FuncDef ends with the '}' matching
+     * the first '{' of its body, and a Decl ends with the first ';' outside braces, then every top-level node
+     * is parsed by a worker, and the results are linked into the CompUnit chain in order
+     * @param scanner: the input scanner, its whole token stream is scanned first
+     * @param[out] ast: an empty FlatAst, it is the same as Parser::get_flat_abstract_syntax_tree() results
+     * @param thread_num: the number of threads, including the calling thread
+     */
+    void parse_parallel(Scanner &scanner, FlatAst &ast, uint32_t thread_num);
+
 } // namespace frontend
 
 #endif
\ No newline at end of file
@@ -14,7 +14,10 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 
+#include"ir/ir_symbol.h"
+
 #include<string>
+#include<cstdint>
 
 namespace frontend {
 
@@ -57,12 +60,20 @@ enum class TokenType{
     NEQ,		// !=
     AND,        // &&
     OR,         // ||
+    ENDTK,      // end of the token stream, it is never produced by scanner
 };
 std::string toString(TokenType);
 
 struct Token {
     TokenType type;
-    std::string value;
+    ir::Symbol value;   // interned, so copying a Token does not copy its text
+};
+
+// a Token which does not own its text, its text is [offset, offset + length) of the source buffer
+struct TokenView {
+    TokenType type;
+    uint32_t offset;
+    uint32_t length;
 };
 
 
@@ -6,5 +6,7 @@
 #include"ir/ir_instruction.h"
 #include"ir/ir_function.h"
 #include"ir/ir_program.h"
+#include"ir/ir_compact.h"
+#include"ir/ir_cfg.h"
 
 #endif
\ No newline at end of file
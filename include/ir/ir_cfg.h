@@ -0,0 +1,103 @@
+#ifndef IRCFG_H
+#define IRCFG_H
+
+#include "ir/ir_operand.h"
+#include "ir/ir_instruction.h"
+#include "ir/ir_function.h"
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace ir
+{
+
+// a basic block, the jumps are not kept as instructions, the targets are resolved into succs
+// a block ends with a _return, or a jump to succs[0] if cond is not null, and falls through or jumps to succs.back() otherwise
+// in SSA form, the phis are at the beginning of insts, the k-th incoming value of a phi comes from preds[k]
+struct BasicBlock {
+    std::vector<Instruction*> insts;    // no _goto, a _return can only be the last one
+    Operand cond;                       // condition of the conditional jump to succs[0], null if there is no conditional jump
+    std::vector<uint32_t> preds;        // ids of predecessors, one for each edge
+    std::vector<uint32_t> succs;        // ids of successors, [taken, not taken] if cond is not null
+
+    bool is_return() const { return insts.size() && insts.back()->op == Operator::_return; }
+
+    /**
+     * @brief remove preds[k], and the k-th incoming value of the phis
+     */
+    void remove_pred(size_t k);
+};
+
+// the control flow graph of a Function, blocks are numbered, the number is also the order when lowered
+// the exit block is empty, a _return or a jump to the end of the function goes to it
+struct CFG {
+    std::vector<BasicBlock> blocks;
+    uint32_t entry;                     // 0, the entry block has no predecessor
+    uint32_t exit;                      // the last block when built
+    uint32_t vreg_cnt;                  // vregs of the function are less than it
+
+    /**
+     * @brief constructor, split func into basic blocks, the instructions are shared with func, the _goto are not used
+     */
+    explicit CFG(const Function& func);
+
+    /**
+     * @brief add an empty block which has no edge
+     * @return the id of the block
+     */
+    uint32_t add_block();
+
+    /**
+     * @brief add an edge, the successor is appended to succs of from
+     */
+    void add_edge(uint32_t from, uint32_t to);
+
+    /**
+     * @brief change the successor old_to of from to new_to, the preds of old_to and new_to are updated,
+     * and the incoming value from from is removed from the phis of old_to, new_to should have no phi
+     */
+    void redirect_edge(uint32_t from, uint32_t old_to, uint32_t new_to);
+
+    /**
+     * @brief add an empty block on the edge from -> to, it replaces from in the preds of to,
+     * so the phis of to are not changed
+     * @return the id of the new block
+     */
+    uint32_t split_edge(uint32_t from, uint32_t to);
+
+    /**
+     * @brief a vreg which is not used in the function
+     */
+    Symbol new_vreg();
+
+    /**
+     * @brief remove the blocks which can not be reached from the entry, the exit block is always kept,
+     * the other blocks are renumbered in the same order
+     * @return true if any block is removed
+     */
+    bool remove_unreachable();
+
+    /**
+     * @brief blocks in reverse post order from the entry, unreachable blocks are not included
+     */
+    std::vector<uint32_t> reverse_post_order() const;
+
+    size_t inst_count() const;      // instructions in blocks, the jumps are not counted
+    size_t lowered_size() const;    // instructions after lower()
+
+    /**
+     * @brief write the blocks into func.InstVec in the order of their numbers, the exit block is at the end,
+     * a _goto is added for every jump which is not a fall through, there should be no phi
+     */
+    void lower(Function& func) const;
+
+    std::string draw() const;
+
+private:
+    std::vector<uint32_t> layout() const;                       // the order of blocks when lowered
+    size_t jump_num(const std::vector<uint32_t>& order, size_t k) const;  // _goto added after order[k]
+};
+
+}
+#endif
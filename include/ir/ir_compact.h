@@ -0,0 +1,88 @@
+#ifndef IRCOMPACT_H
+#define IRCOMPACT_H
+
+#include "ir/ir_operand.h"
+#include "ir/ir_operator.h"
+#include "ir/ir_function.h"
+#include "ir/ir_program.h"
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <unordered_map>
+
+namespace ir
+{
+
+// an instruction of CompactFunction, 16 bytes without pointers or vtable
+// op1, op2 and des are indexes in CompactFunction::operands, 0 is Operand()
+// for call and phi, the arguments or incoming values are args[op2, op2 + argc)
+struct CompactInst {
+    uint8_t op;             // Operator
+    uint8_t reserved;       // 0
+    uint16_t argc;          // number of arguments of call or incoming values of phi, 0 for others
+    uint32_t op1;
+    uint32_t op2;
+    uint32_t des;
+};
+
+// a Function whose instructions are kept in one array, every different Operand is kept once in the operand table,
+// and the value of every literal operand is parsed once into the literal pool
+struct CompactFunction {
+    Symbol name;
+    Type returnType;
+    std::vector<uint32_t> params;       // ParameterList, indexes in operands
+    std::vector<CompactInst> insts;
+    std::vector<uint32_t> args;         // arguments of all calls and incoming values of all phis, indexes in operands
+    std::vector<Operand> operands;      // the operand table, operands[0] is Operand()
+    std::vector<uint32_t> values;       // the literal pool, bits of int or float value of operands[i], 0 if it is not a literal
+
+    CompactFunction();
+
+    /**
+     * @brief constructor, convert a Function
+     */
+    explicit CompactFunction(const Function& func);
+
+    /**
+     * @brief the index of op in operands, op is added if it is not in the table
+     */
+    uint32_t add_operand(const Operand& op);
+
+    /**
+     * @brief convert back to a Function, the instructions are new, a call is a CallInst and a phi is a PhiInst
+     */
+    Function to_function() const;
+
+    bool is_literal(uint32_t id) const { return operands[id].type == Type::IntLiteral || operands[id].type == Type::FloatLiteral; }
+    int32_t int_value(uint32_t id) const { return (int32_t)values[id]; }    // only for IntLiteral
+    float float_value(uint32_t id) const;                                   // only for FloatLiteral
+
+    size_t bytes_used() const;  // bytes used by the arrays
+
+private:
+    std::unordered_map<uint64_t, uint32_t> operand_index;   // name id and type of an operand -> index in operands
+};
+
+struct CompactProgram {
+    std::vector<CompactFunction> functions;
+    std::vector<GlobalVal> globalVal;
+
+    CompactProgram();
+
+    /**
+     * @brief constructor, convert a Program, the functions of program are not changed
+     */
+    explicit CompactProgram(const Program& program);
+
+    /**
+     * @brief convert back to a Program, program.draw() is the same as the Program converted from
+     */
+    Program to_program() const;
+
+    size_t inst_count() const;
+    size_t bytes_used() const;
+};
+
+}
+#endif
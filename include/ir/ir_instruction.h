@@ -19,6 +19,7 @@ struct Instruction {
     Instruction();
     Instruction(const Operand& op1, const Operand& op2, const Operand& des, const Operator& op);
     virtual std::string draw() const;
+    virtual ~Instruction() = default;
 };
 
 struct CallInst: public Instruction{
@@ -28,6 +29,12 @@ struct CallInst: public Instruction{
     std::string draw() const;
 };
 
+struct PhiInst: public Instruction{
+    std::vector<Operand> incomingList;     // 第 k 个值来自所在基本块的第 k 个前驱
+    PhiInst(const Operand& des, std::vector<Operand> incomingList);
+    std::string draw() const;
+};
+
 
 }
 #endif
@@ -1,6 +1,8 @@
 #ifndef IROPERAND_H
 #define IROPERAND_H
 
+#include "ir/ir_symbol.h"
+
 #include <string>
 
 
@@ -19,9 +21,9 @@ enum class Type {
 std::string toString(Type t);
 
 struct Operand {
-    std::string name;
+    Symbol name;
     Type type;
-    Operand(std::string = "null", Type = Type::null);
+    Operand(Symbol = "null", Type = Type::null);
 };
 
 }
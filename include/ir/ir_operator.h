@@ -15,6 +15,9 @@ enum class Operator {
     store,      // store    des,    op1,    op2    op2为下标 -> 偏移量  op1为 store 的数组名, des 为被存储的变量
     load,       // load     des,    op1,    op2    op2为下标 -> 偏移量  op1为 load 的数组名, des 为被赋值变量
     getptr,     // op1: arr_name, op2: arr_off
+    fill,       // fill     des,    op1,    op2    op1 数组从下标 op2 开始的 des 个元素置为 0
+    copy,       // copy     des,    op1,    op2    把常量数组 op2 的前 des 个元素复制到 op1 数组的开头
+    phi,        // phi      des,    [v0, v1, ...]   只出现在 SSA 形式的 CFG 中, vk 来自基本块的第 k 个前驱
 
     def,
     fdef,
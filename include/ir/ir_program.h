@@ -6,6 +6,7 @@
 
 #include <vector>
 #include <string>
+#include <cstdint>
 
 namespace ir
 {
@@ -13,6 +14,9 @@ namespace ir
     {
         ir::Operand val;
         int maxlen = 0;     //为数组长度设计
+        // 静态初始值, 每个元素一个字, float 为其二进制; 末尾的 0 被省略, 为空时全部为 0
+        // 初始值为常量的全局变量不在 _global 中初始化
+        std::vector<uint32_t> init;
         GlobalVal(ir::Operand va);
         GlobalVal(ir::Operand va, int len);
     };
@@ -0,0 +1,80 @@
+#ifndef IRSYMBOL_H
+#define IRSYMBOL_H
+
+#include <string>
+#include <cstdint>
+#include <ostream>
+#include <functional>
+
+namespace ir {
+
+// an interned string, it is shared by Token, AST, symbol table, IR, executor and backend
+// every Symbol with the same text has the same id, so Symbols are compared and hashed as integers
+// the text is kept in a global table until the program exits
+// a virtual register "temp_n" is only a number, its text is made when str() is called for the first time,
+// Symbol("temp_n") is the same as Symbol::vreg(n)
+// a literal keeps its value instead of its text in the same way, Symbol("-12") is the same as Symbol::int_literal(-12),
+// but a float literal is never made from text, because "1.5" and "1.500000" are different texts
+struct Symbol {
+    static const uint32_t VREG_BIT = 0x80000000u;
+    static const uint32_t LITERAL_BIT = 0x40000000u;
+
+    Symbol();                               // the empty string
+    Symbol(const std::string&);
+    Symbol(const char*);
+    Symbol(const char*, size_t len);
+
+    static Symbol vreg(uint32_t n);         // the virtual register "temp_n", nothing is allocated
+    static Symbol int_literal(int32_t v);   // the decimal text of v
+    static Symbol float_literal(float v);   // the text of std::to_string(v), or more digits if it is not exact
+
+    uint32_t id() const { return _id; }     // stable during a run, 0 is the empty string
+    uint32_t hash() const;                  // FNV-1a of the text, it does not depend on the intern order
+    const std::string& str() const;
+    const char* c_str() const { return str().c_str(); }
+    bool empty() const { return _id == 0; }
+    bool is_vreg() const { return _id & VREG_BIT; }
+    uint32_t vreg_index() const { return _id & ~VREG_BIT; }     // n of "temp_n", only for vregs
+    bool is_literal() const { return (_id & (VREG_BIT | LITERAL_BIT)) == LITERAL_BIT; }
+    bool is_float_literal() const;
+    int32_t int_value() const;              // only for int literals
+    float float_value() const;              // only for float literals
+    operator const std::string&() const { return str(); }
+
+private:
+    uint32_t _id;
+};
+
+// number of different strings interned, for debug
+uint32_t symbol_count();
+
+inline bool operator==(Symbol a, Symbol b) { return a.id() == b.id(); }
+inline bool operator!=(Symbol a, Symbol b) { return a.id() != b.id(); }
+inline bool operator==(Symbol a, const std::string& b) { return a.str() == b; }
+inline bool operator!=(Symbol a, const std::string& b) { return a.str() != b; }
+inline bool operator==(const std::string& a, Symbol b) { return a == b.str(); }
+inline bool operator!=(const std::string& a, Symbol b) { return a != b.str(); }
+inline bool operator==(Symbol a, const char* b) { return a.str() == b; }
+inline bool operator!=(Symbol a, const char* b) { return a.str() != b; }
+
+inline std::string operator+(Symbol a, Symbol b) { return a.str() + b.str(); }
+inline std::string operator+(Symbol a, const std::string& b) { return a.str() + b; }
+inline std::string operator+(const std::string& a, Symbol b) { return a + b.str(); }
+inline std::string operator+(Symbol a, const char* b) { return a.str() + b; }
+inline std::string operator+(const char* a, Symbol b) { return a + b.str(); }
+
+inline std::ostream& operator<<(std::ostream& os, Symbol s) {
+    return s.is_vreg() ? os << "temp_" << s.vreg_index() : os << s.str();
+}
+
+}
+
+namespace std {
+// ids are unique, so the id itself is a perfect hash
+template <>
+struct hash<ir::Symbol> {
+    size_t operator()(ir::Symbol s) const { return s.id(); }
+};
+}
+
+#endif
@@ -0,0 +1,54 @@
+/**
+ * @file analysis.h
+ * @brief the analyses of a function which passes share, they are built on the first query and kept until invalidated
+ * @version 0.1
+ * @date 2023-03-24
+ *
+ */
+
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include "opt/dominance.h"
+#include "opt/loops.h"
+
+#include <memory>
+#include <cstdint>
+
+namespace ir
+{
+
+    // the analyses only depend on the blocks and the edges of the CFG, a pass which changes them calls invalidate()
+    struct AnalysisManager
+    {
+        explicit AnalysisManager(CFG &cfg);
+
+        const DominatorTree &dominators();
+        const DominatorTree &post_dominators();
+        const LoopInfo &loops();
+
+        /**
+         * @brief make sure loop l has a preheader, the loops stay valid and the dominator trees are invalidated
+         * @return the preheader
+         */
+        uint32_t insert_preheader(uint32_t l);
+
+        /**
+         * @brief insert_preheader() for every loop, the dominator trees are invalidated once
+         */
+        void insert_preheaders();
+
+        /**
+         * @brief drop all the analyses
+         */
+        void invalidate();
+
+    private:
+        CFG &cfg;
+        std::unique_ptr<DominatorTree> dom, post_dom;
+        std::unique_ptr<LoopInfo> loop_info;
+    };
+
+} // namespace ir
+
+#endif
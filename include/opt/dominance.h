@@ -0,0 +1,59 @@
+/**
+ * @file dominance.h
+ * @brief the dominator tree, the post-dominator tree and the dominance frontiers of a CFG,
+ * built by the algorithm of Cooper, Harvey and Kennedy, "A Simple, Fast Dominance Algorithm"
+ * @version 0.1
+ * @date 2023-03-22
+ *
+ */
+
+#ifndef DOMINANCE_H
+#define DOMINANCE_H
+
+#include "ir/ir_cfg.h"
+
+#include <vector>
+#include <cstdint>
+
+namespace ir
+{
+
+    struct DominatorTree
+    {
+        static const uint32_t NONE = UINT32_MAX;
+
+        std::vector<uint32_t> idom;                    // the immediate dominator, idom[root] = root, NONE for unreachable blocks
+        std::vector<std::vector<uint32_t>> children;   // the children in the tree
+        std::vector<uint32_t> rpo;                     // the reachable blocks in reverse post order
+        uint32_t root;                                 // the entry, or the exit for the post-dominator tree
+        bool is_post;
+
+        /**
+         * @brief constructor, build the tree of the blocks reachable from the entry,
+         * or the post-dominator tree of the blocks which reach the exit on the reversed CFG if post_dom is true
+         */
+        explicit DominatorTree(const CFG &cfg, bool post_dom = false);
+
+        bool is_reachable(uint32_t b) const { return idom[b] != NONE; }
+
+        /**
+         * @brief true if every path from the root to b goes through a, a block dominates itself, O(1)
+         */
+        bool dominates(uint32_t a, uint32_t b) const;
+
+        /**
+         * @brief the dominance frontier of every block, the blocks where the dominance of the block ends,
+         * for the post-dominator tree they are the blocks each block is control dependent on
+         */
+        std::vector<std::vector<uint32_t>> frontiers(const CFG &cfg) const;
+
+    private:
+        std::vector<uint32_t> pre, post;   // the preorder and postorder numbers in the tree
+
+        // the edges into b, the succs for the post-dominator tree
+        const std::vector<uint32_t> &in_edges(const CFG &cfg, uint32_t b) const { return is_post ? cfg.blocks[b].succs : cfg.blocks[b].preds; }
+    };
+
+} // namespace ir
+
+#endif
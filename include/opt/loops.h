@@ -0,0 +1,71 @@
+/**
+ * @file loops.h
+ * @brief the natural loops of a CFG, their nesting, and the insertion of loop preheaders
+ * @version 0.1
+ * @date 2023-03-24
+ *
+ */
+
+#ifndef LOOPS_H
+#define LOOPS_H
+
+#include "opt/dominance.h"
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace ir
+{
+
+    // the natural loops of the back edges to one header, a back edge goes to a block which dominates its source
+    struct Loop
+    {
+        uint32_t header;
+        uint32_t parent;                  // the innermost loop containing this one, NONE for an outermost loop
+        uint32_t depth;                   // 1 for an outermost loop
+        std::vector<uint32_t> children;
+        std::vector<uint32_t> blocks;     // the blocks in the loop and its inner loops, the header is the first one
+        std::vector<uint32_t> latches;    // the sources of the back edges
+    };
+
+    struct LoopInfo
+    {
+        static const uint32_t NONE = UINT32_MAX;
+
+        std::vector<Loop> loops;          // an inner loop comes before the loops containing it
+        std::vector<uint32_t> loop_of;    // the innermost loop of every block, NONE if it is in no loop
+
+        /**
+         * @brief constructor, find the loops of the reachable blocks, the edges to a header which does not dominate
+         * the source (in an irreducible CFG) make no loop
+         */
+        LoopInfo(const CFG &cfg, const DominatorTree &dom);
+
+        uint32_t depth(uint32_t b) const { return loop_of[b] == NONE ? 0 : loops[loop_of[b]].depth; }
+
+        /**
+         * @brief true if block b is in loop l or in an inner loop of l, O(depth)
+         */
+        bool contains(uint32_t l, uint32_t b) const;
+
+        /**
+         * @brief the only block outside loop l which jumps to the header, if it has no other successor
+         * @return the block, NONE if the loop has no preheader
+         */
+        uint32_t preheader(const CFG &cfg, uint32_t l) const;
+
+        /**
+         * @brief add a preheader for loop l if it has none, all the edges from outside the loop to the header go to it,
+         * the phis of the header get one incoming value from it, which is a new phi of the preheader if there are many edges.
+         * loops stay up to date, the dominator trees of cfg have to be built again
+         * @return the preheader
+         */
+        uint32_t insert_preheader(CFG &cfg, uint32_t l);
+
+        std::string draw() const;
+    };
+
+} // namespace ir
+
+#endif
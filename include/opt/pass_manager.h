@@ -0,0 +1,108 @@
+/**
+ * @file pass_manager.h
+ * @brief
+ * the optimization stage, a pipeline of passes over the functions of an ir::Program.
+ * it runs after Analyzer::get_ir_program, before the IR is printed, executed or sent to the Generator.
+ * every pass has the lowest -O level it runs at, and can be enabled or disabled by name.
+ * the CFG of every function is built once before the first pass, and lowered back after the last one,
+ * its analyses (see analysis.h) are shared by the passes
+ * @version 0.1
+ * @date 2023-03-20
+ *
+ */
+
+#ifndef PASS_MANAGER_H
+#define PASS_MANAGER_H
+
+#include "ir/ir.h"
+#include "opt/analysis.h"
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace ir
+{
+
+    // an optimization over one function, it changes the CFG of the function, func.InstVec is out of date until the CFG is lowered,
+    // the analyses of the CFG are cached across passes, a pass which changes the blocks or the edges invalidates them
+    struct Pass
+    {
+        virtual ~Pass() = default;
+        virtual const char *name() const = 0;   // used in -f<name> and -fno-<name>
+
+        /**
+         * @brief the pass which has to run after this one whenever this one runs, such as out-of-ssa after mem2reg
+         */
+        virtual const char *required_pass() const { return nullptr; }
+
+        /**
+         * @brief called once before the pass runs over the functions of program
+         */
+        virtual void init(Program &program) {}
+
+        virtual void run(Function &func, CFG &cfg, AnalysisManager &analyses) = 0;
+    };
+
+    struct PassManager
+    {
+        /**
+         * @brief constructor, the built-in pipeline at -O0, so no pass runs until set_option() is called
+         */
+        PassManager();
+        ~PassManager();
+
+        /**
+         * @brief append a pass to the pipeline, the manager deletes it
+         * @param level: the lowest -O level the pass runs at
+         */
+        void add_pass(Pass *pass, int level);
+
+        /**
+         * @brief apply a command line option
+         *  -O0 -O1 -O2:    the level
+         *  -f<name>:       run pass <name> at any level
+         *  -fno-<name>:    never run pass <name>
+         *  -ftime-report:  print the time and the instruction counts of every pass to stderr
+         * @return false if the option is unknown
+         */
+        bool set_option(const std::string &opt);
+
+        /**
+         * @brief true if pass name runs, a pass required by another pass which runs always runs
+         */
+        bool is_enabled(const std::string &name) const;
+
+        /**
+         * @brief run the enabled passes in order, every pass runs over all functions before the next one,
+         * the functions are not changed if no pass runs
+         */
+        void run(Program &program);
+
+        /**
+         * @brief a line for every pass that runs: time, and the number of instructions before and after it
+         */
+        std::string report() const;
+
+    private:
+        struct PassEntry
+        {
+            Pass *pass;
+            int level;
+            double seconds;      // 所有函数上运行的总时间
+            size_t inst_before;  // 运行前所有函数 lower 之后的指令数
+            size_t inst_after;
+            bool ran;
+        };
+        std::vector<PassEntry> passes;
+        std::map<std::string, bool> switches;   // -f<name> and -fno-<name>
+        int level;
+        bool time_report;
+
+        bool is_selected(const PassEntry &entry) const;  // selected by the level or a switch
+    };
+
+} // namespace ir
+
+#endif
@@ -0,0 +1,90 @@
+/**
+ * @file passes.h
+ * @brief the built-in passes of PassManager
+ * @version 0.1
+ * @date 2023-03-20
+ *
+ */
+
+#ifndef PASSES_H
+#define PASSES_H
+
+#include "opt/pass_manager.h"
+
+#include <unordered_set>
+
+namespace ir
+{
+
+    /**
+     * @brief true if an instruction of op only writes des, and has no other side effect
+     */
+    bool is_pure(Operator op);
+
+    /**
+     * @brief true if an instruction of op writes des
+     */
+    bool is_def(Operator op);
+
+    /**
+     * @brief call f for every operand which inst reads, including the arguments of call and the incoming values of phi
+     */
+    template <typename F>
+    void for_each_use(Instruction *inst, F f)
+    {
+        f(inst->op1);
+        f(inst->op2);
+        if (!is_def(inst->op))
+            f(inst->des);
+        if (inst->op == Operator::call)
+            for (auto &arg : static_cast<CallInst *>(inst)->argumentList)
+                f(arg);
+        else if (inst->op == Operator::phi)
+            for (auto &value : static_cast<PhiInst *>(inst)->incomingList)
+                f(value);
+    }
+
+    // remove the blocks which are never reached, and jump over the blocks which only jump to another block
+    struct SimplifyCFG : Pass
+    {
+        const char *name() const override { return "simplify-cfg"; }
+        void run(Function &func, CFG &cfg, AnalysisManager &analyses) override;
+    };
+
+    // put the scalar Int and Float local variables and the vregs which are written more than once into SSA form,
+    // the new values are vregs, and phis are added at the iterated dominance frontiers of the writes
+    struct Mem2Reg : Pass
+    {
+        const char *name() const override { return "mem2reg"; }
+        const char *required_pass() const override { return "out-of-ssa"; }
+        void init(Program &program) override;
+        void run(Function &func, CFG &cfg, AnalysisManager &analyses) override;
+
+    private:
+        std::unordered_set<Symbol> globals;
+    };
+
+    // in a basic block, use x instead of a vreg which is a copy of x, until either of them is written again
+    struct CopyPropagation : Pass
+    {
+        const char *name() const override { return "copy-prop"; }
+        void run(Function &func, CFG &cfg, AnalysisManager &analyses) override;
+    };
+
+    // remove the instructions without side effect whose results are vregs that no instruction with side effect depends on
+    struct DeadCodeElimination : Pass
+    {
+        const char *name() const override { return "dce"; }
+        void run(Function &func, CFG &cfg, AnalysisManager &analyses) override;
+    };
+
+    // replace the phis with copies at the end of the predecessors, the critical edges are split first
+    struct OutOfSSA : Pass
+    {
+        const char *name() const override { return "out-of-ssa"; }
+        void run(Function &func, CFG &cfg, AnalysisManager &analyses) override;
+    };
+
+} // namespace ir
+
+#endif
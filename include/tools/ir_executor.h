@@ -15,7 +15,9 @@
 #include"ir/ir.h"
 
 #include<map>
+#include<unordered_map>
 #include<stack>
+#include<vector>
 #include<string>
 #include<cstdint>
 #include<fstream>
@@ -54,7 +56,8 @@ struct Value {
 struct Context {
     uint32_t pc;                            // program counter of a function
     Value* retval_addr;                   // if it's not nullptr, this addr will be written when exit a context, 
-    std::map<std::string, Value> mem;
+    std::unordered_map<Symbol, Value> mem;
+    std::vector<Value> vregs;               // values of vregs, indexed by the vreg number, Type::null if not written
     const ir::Function* pfunc;              // executing which function 
 
     /**
@@ -69,7 +72,7 @@ struct Executor {
     std::ostream& out;
 
     const ir::Program* program;
-    std::map<std::string, Value> global_vars;
+    std::unordered_map<Symbol, Value> global_vars;
 
     Context* cur_ctx;
     Instruction* cur_inst;
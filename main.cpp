@@ -1,22 +1,26 @@
 #include"front/lexical.h"
 #include"front/syntax.h"
 #include"front/semantic.h"
+#include"front/ast_cache.h"
 #include"ir/ir.h"
+#include"opt/pass_manager.h"
 #include"tools/ir_executor.h"
 #include"backend/generator.h"
 
 #include<string>
 #include<vector>
 #include<cassert>
+#include<cstdlib>
 #include<fstream>
 #include<iostream>
+#include<thread>
 
 using std::string;
 using std::vector;
 
 /**
  * commad line:
- * compiler <src_filename> -step -o <output_filename> [opt]
+ * compiler <src_filename> -step -o <output_filename> [opt...]
  * 
  * step:
  *  -s0: output of scanner
@@ -27,11 +31,18 @@ using std::vector;
  *  -all[FIXME]
  * 
  * opt:
- * [FIXME]
+ *  -O0 -O1 -O2:    optimization level, default -O0
+ *  -f<pass>:       run a pass at any level, such as -fdce
+ *  -fno-<pass>:    do not run a pass
+ *  -ftime-report:  print the time and the instruction count change of every pass to stderr
+ *
+ * environment:
+ *  AST_CACHE_DIR: a directory to cache the AST of every source file, the AST is loaded from it
+ *                 when the same source text is compiled again
  */
 
 int main(int argc, char** argv) {
-    assert((argc == 5 || argc == 6) && "command line should be: compiler <src_filename> -step -o <output_filename> [opt]");
+    assert(argc >= 5 && "command line should be: compiler <src_filename> -step -o <output_filename> [opt...]");
     string src = argv[1];
     string step = argv[2];
     string des = argv[4];
@@ -39,30 +50,56 @@ int main(int argc, char** argv) {
     assert(output_file.is_open() && "output file can not open");
 
     frontend::Scanner scanner(src);
-    vector<frontend::Token> tk_stream = scanner.run();
 
     // compiler <src_filename> -s0 -o <output_filename>
     if(step == "-s0"){
-        for(const auto& tk: tk_stream){
-            output_file << frontend::toString(tk.type) << "\t" << tk.value << std::endl;
+        // tokens refer to the mapped source file, so their text is written without copying
+        vector<frontend::TokenView> tk_views = scanner.run_mapped();
+        const char* text = scanner.get_source().data();
+        for(const auto& tk: tk_views){
+            output_file << frontend::toString(tk.type) << "\t";
+            output_file.write(text + tk.offset, tk.length);
+            output_file << '\n';
         }
         return 0;
     }
-    
-    frontend::Parser parser(tk_stream);
-    frontend::CompUnit* node = parser.get_abstract_syntax_tree();
+
+    // tokens are scanned while parsing, the parser only keeps a few tokens to look ahead,
+    // and the AST is kept in a compact FlatAst.
+    // if AST_CACHE_DIR is set, the AST of a source text which was parsed before is loaded from the directory
+    frontend::FlatAst ast;
+    const char* cache_dir = std::getenv("AST_CACHE_DIR");
+    if(!cache_dir || !frontend::AstCache(cache_dir, src).load(ast)) {
+        // large files are parsed by several threads, one top-level Decl or FuncDef at a time
+        uint32_t thread_num = std::thread::hardware_concurrency();
+        if(thread_num > 1 && scanner.get_source_size() >= frontend::PARALLEL_PARSE_MIN_SIZE) {
+            frontend::parse_parallel(scanner, ast, thread_num);
+        }
+        else {
+            frontend::Parser parser(scanner);
+            parser.get_flat_abstract_syntax_tree(ast);
+        }
+        if(cache_dir)
+            frontend::AstCache(cache_dir, src).save(ast);
+    }
 
     // compiler <src_filename> -s1 -o <output_filename>
     if(step == "-s1") {
-        Json::Value json_output;
-        Json::StyledWriter writer;
-        node->get_json_output(json_output);
-        output_file << writer.write(json_output);
+        // the json text is written while walking the AST, it is never kept in memory as a whole
+        ast.write_json(output_file);
         return 0;
     }
     
     frontend::Analyzer analyzer;
-    auto program = analyzer.get_ir_program(node);
+    auto program = analyzer.get_ir_program(ast);
+
+    // the IR is optimized before it is printed, executed or sent to the backend
+    ir::PassManager pass_manager;
+    for (int i = 5; i < argc; i++) {
+        bool known = pass_manager.set_option(argv[i]);
+        assert(known && "unknown optimization option");
+    }
+    pass_manager.run(program);
     
     // compiler <src_filename> -s2 -o <output_filename>
     if(step == "-s2") {
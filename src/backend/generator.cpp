@@ -88,6 +88,17 @@ void backend::Generator::store(ir::Operand operand, std::string reg, std::string
     free_temp_reg(temp_reg);
 }
 
+void backend::Generator::load_address(ir::Operand operand, std::string reg)
+{
+    if (global_vals.count(operand.name))
+    {
+        fout << "\tla " << reg << ", " << operand.name << std::endl;
+        return;
+    }
+    fout << "\tli " << reg << ", " << stackVar.find_operand(operand) << std::endl;
+    fout << "\tadd " << reg << ", " << reg << ", sp" << std::endl;
+}
+
 std::map<std::string, bool> temporaies{{"t3", 0}, {"t4", 0}, {"t5", 0}, {"t6", 0}};
 
 std::string backend::Generator::get_temp_reg()
@@ -110,18 +121,40 @@ void backend::Generator::free_temp_reg(std::string reg)
 
 void backend::Generator::gen()
 {
-    // generate global variables
-    fout << "\t.data" << std::endl;
+    // generate global variables, the ones with initial values are in .data, the others are all 0 and in .bss
+    const char *section = nullptr;
     for (auto &global_val : program.globalVal)
     {
         global_vals.insert(global_val.val.name);
+        auto &init = global_val.init;
+        size_t size = (global_val.maxlen ? global_val.maxlen : 1) * 4;
+        const char *val_section = init.empty() ? ".bss" : ".data";
+        if (section != val_section)
+        {
+            section = val_section;
+            fout << "\t" << section << std::endl;
+        }
         fout << "\t.global " << global_val.val.name << std::endl;
         fout << "\t.type " << global_val.val.name << ", @object" << std::endl;
-        fout << "\t.size " << global_val.val.name << ", " << (global_val.maxlen ? global_val.maxlen * 4 : 4) << std::endl;
+        fout << "\t.size " << global_val.val.name << ", " << size << std::endl;
         fout << global_val.val.name << ":" << std::endl;
-        fout << "\t.word "
-             << "0" << std::endl
-             << std::endl;
+        // a run of 0 is written as one .zero
+        for (size_t i = 0; i < init.size();)
+        {
+            if (init[i])
+            {
+                fout << "\t.word " << (int32_t)init[i++] << std::endl;
+                continue;
+            }
+            size_t j = i;
+            while (j < init.size() && init[j] == 0)
+                j++;
+            fout << "\t.zero " << (j - i) * 4 << std::endl;
+            i = j;
+        }
+        if (init.size() * 4 < size)
+            fout << "\t.zero " << size - init.size() * 4 << std::endl;
+        fout << std::endl;
     }
     // generate functions
     for (auto &func : program.functions)
@@ -137,8 +170,8 @@ int get_frame_size(const ir::Function &func, backend::stackVarMap &stackVar)
     auto &params = func.ParameterList;
     auto &inst_vec = func.InstVec;
     int frame_size = 0;
-    std::set<std::string> var_set;
-    std::set<std::string> params_set;
+    std::unordered_set<ir::Symbol> var_set;
+    std::unordered_set<ir::Symbol> params_set;
 
     for (auto &param : params)
     {
@@ -896,6 +929,41 @@ void backend::Generator::gen_instr(const ir::Instruction &instruction, int index
         store(des, rd);
         break;
     }
+    case ir::Operator::fill: // fill des, op1, op2 : op1[op2 : op2 + des] = 0
+    {
+        fout << "# fill" << std::endl;
+        assert(op2.type == ir::Type::IntLiteral && des.type == ir::Type::IntLiteral && "wrong type");
+        auto loop = ".L" + std::to_string(label_cnt++);
+        load_address(op1, "t0");
+        fout << "\tli t1, " << std::stoi(op2.name) * 4 << std::endl;
+        fout << "\tadd t0, t0, t1" << std::endl;
+        fout << "\tli t1, " << des.name << std::endl;
+        fout << loop << ":" << std::endl;
+        fout << "\tsw zero, 0(t0)" << std::endl;
+        fout << "\taddi t0, t0, 4" << std::endl;
+        fout << "\taddi t1, t1, -1" << std::endl;
+        fout << "\tbnez t1, " << loop << std::endl;
+        break;
+    }
+    case ir::Operator::copy: // copy des, op1, op2 : op1[0 : des] = op2[0 : des]
+    {
+        fout << "# copy" << std::endl;
+        assert(des.type == ir::Type::IntLiteral && "wrong type");
+        auto loop = ".L" + std::to_string(label_cnt++);
+        auto value = get_temp_reg();
+        load_address(op1, "t0");
+        load_address(op2, "t1");
+        fout << "\tli t2, " << des.name << std::endl;
+        fout << loop << ":" << std::endl;
+        fout << "\tlw " << value << ", 0(t1)" << std::endl;
+        fout << "\tsw " << value << ", 0(t0)" << std::endl;
+        fout << "\taddi t0, t0, 4" << std::endl;
+        fout << "\taddi t1, t1, 4" << std::endl;
+        fout << "\taddi t2, t2, -1" << std::endl;
+        fout << "\tbnez t2, " << loop << std::endl;
+        free_temp_reg(value);
+        break;
+    }
     case ir::Operator::alloc:
     {
         break;
@@ -2,6 +2,7 @@
 #include"ir/ir.h"
 
 #include<cassert>
+#include<cstdint>
 
 using frontend::AstNode;
 using frontend::Term;
@@ -37,20 +38,65 @@ using frontend::LAndExp;
 using frontend::LOrExp;
 using frontend::ConstExp;
 
-AstNode::AstNode(NodeType t, AstNode* p): type(t), parent(p), children() {}
+frontend::AstArena::AstArena(): blocks(), cur(nullptr), end(nullptr), nodes(0), used(0), dtors() {}
 
-AstNode::~AstNode() {
-    for(auto it: children)
-        delete it;
+frontend::AstArena::~AstArena() {
+    reset();
 }
 
+void* frontend::AstArena::allocate(size_t size, size_t align) {
+    used += size;
+    // a large array has its own block, so the rest of current block is not wasted
+    if (size > BLOCK_SIZE / 4) {
+        char* block = new char[size];
+        blocks.push_back(block);
+        return block;
+    }
+    size_t pad = (align - (reinterpret_cast<uintptr_t>(cur) & (align - 1))) & (align - 1);
+    if (!cur || cur + pad + size > end) {
+        char* block = new char[BLOCK_SIZE];
+        blocks.push_back(block);
+        cur = block;
+        end = block + BLOCK_SIZE;
+        pad = 0;    // new[] is aligned for every node type
+    }
+    used += pad;
+    void* ptr = cur + pad;
+    cur += pad + size;
+    return ptr;
+}
+
+void frontend::AstArena::reset() {
+    for (auto it = dtors.rbegin(); it != dtors.rend(); it++)
+        it->first(it->second);
+    dtors.clear();
+    for (auto block: blocks)
+        delete[] block;
+    blocks.clear();
+    cur = end = nullptr;
+    nodes = used = 0;
+}
+
+size_t frontend::AstArena::node_count() const {
+    return nodes;
+}
+
+size_t frontend::AstArena::bytes_used() const {
+    return used;
+}
+
+// a child is in the same arena as its parent
+AstNode::AstNode(NodeType t, AstNode* p): type(t), parent(p), children(p ? p->children.get_allocator() : ArenaAllocator<AstNode*>()) {}
+
+AstNode::~AstNode() {}
+
 void AstNode::get_json_output(Json::Value& root) const {
     root["name"] = toString(type);
     if (type == NodeType::TERMINAL) {
         auto termP = dynamic_cast<Term*>(const_cast<AstNode*>(this));
         assert(termP);
         root["type"] = toString(termP->token.type);
-        root["value"] = termP->token.value;
+        root["value"] = termP->token.value.str();
     }
     else {
         root["subtree"] = Json::Value();
@@ -0,0 +1,265 @@
+#include "front/ast_cache.h"
+#include "front/lexical.h"
+
+#include <cassert>
+#include <cstring>
+#include <cstdio>
+#include <chrono>
+#include <fstream>
+
+// #define DEBUG_AST_CACHE
+
+#define AST_CACHE_MAGIC 0x43415953 // "SYAC"
+
+using frontend::AstCache;
+using frontend::AstCacheHeader;
+using frontend::FlatAst;
+using frontend::NodeId;
+using frontend::NodeType;
+using frontend::SourceBuffer;
+using frontend::TokenType;
+
+#ifdef DEBUG_AST_CACHE
+void bench_ast_cache(const std::string &dir, const std::string &filename);
+#endif
+
+static_assert(sizeof(AstCacheHeader) == 48, "AstCacheHeader should have no padding");
+
+uint64_t frontend::hash_bytes(const char *data, size_t size, uint64_t seed)
+{
+    const uint64_t mul = 0x9e3779b97f4a7c15ull;
+    uint64_t h = seed ^ (size * mul);
+    size_t i = 0;
+    // 每次处理 8 个字节, 最后不足 8 个字节的部分补 0
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t w;
+        memcpy(&w, data + i, 8);
+        h = (h ^ w) * mul;
+        h ^= h >> 29;
+    }
+    if (i < size)
+    {
+        uint64_t w = 0;
+        memcpy(&w, data + i, size - i);
+        h = (h ^ w) * mul;
+        h ^= h >> 29;
+    }
+    h ^= h >> 32;
+    h *= mul;
+    h ^= h >> 29;
+    return h;
+}
+
+// the content after the header:
+// kind[node_num], padding to 4 bytes, token[node_num], first_child[node_num], next_sibling[node_num], child_count[node_num],
+// token_type[token_num], padding to 4 bytes, token_end[token_num], text[text_size]
+size_t pad4(size_t size)
+{
+    return (size + 3) & ~(size_t)3;
+}
+
+size_t cache_content_size(size_t node_num, size_t token_num, size_t text_size)
+{
+    return pad4(node_num) + 4 * node_num * sizeof(uint32_t) + pad4(token_num) + token_num * sizeof(uint32_t) + text_size;
+}
+
+template <typename T>
+void append_array(std::string &buf, const std::vector<T> &arr)
+{
+    buf.append(reinterpret_cast<const char *>(arr.data()), arr.size() * sizeof(T));
+}
+
+template <typename T>
+const char *read_array(const char *p, std::vector<T> &arr, size_t n)
+{
+    const T *begin = reinterpret_cast<const T *>(p);
+    arr.assign(begin, begin + n);
+    return p + n * sizeof(T);
+}
+
+AstCache::AstCache(const std::string &dir, const std::string &filename) : path(), source_hash(0), source_size(0), valid(false)
+{
+    SourceBuffer source;
+    if (source.open(filename))
+    {
+        source_hash = hash_bytes(source.data(), source.size(), AST_CACHE_VERSION);
+        source_size = source.size();
+        valid = true;
+    }
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.ast", (unsigned long long)source_hash);
+    path = dir + "/" + name;
+
+#ifdef DEBUG_AST_CACHE
+    static bool benched = false;
+    if (!benched)
+    {
+        benched = true;
+        bench_ast_cache(dir, filename);
+    }
+#endif
+}
+
+const std::string &AstCache::get_path() const
+{
+    return path;
+}
+
+bool AstCache::load(FlatAst &ast) const
+{
+    assert(ast.size() == 0 && "in AstCache::load, ast is not empty");
+    if (!valid)
+        return false;
+    SourceBuffer file;
+    if (!file.open(path) || file.size() < sizeof(AstCacheHeader))
+        return false;
+
+    AstCacheHeader header;
+    memcpy(&header, file.data(), sizeof(header));
+    if (header.magic != AST_CACHE_MAGIC || header.version != AST_CACHE_VERSION || header.source_hash != source_hash ||
+        header.source_size != source_size || header.node_num == 0 ||
+        file.size() != sizeof(header) + cache_content_size(header.node_num, header.token_num, header.text_size))
+        return false;
+    const char *content = file.data() + sizeof(header);
+    if (hash_bytes(content, file.size() - sizeof(header)) != header.checksum)
+        return false;
+
+    size_t n = header.node_num;
+    const char *p = content;
+    read_array(p, ast.kind, n);
+    p += pad4(n);
+    p = read_array(p, ast.token, n);
+    p = read_array(p, ast.first_child, n);
+    p = read_array(p, ast.next_sibling, n);
+    p = read_array(p, ast.child_count, n);
+    std::vector<uint8_t> token_type;
+    std::vector<uint32_t> token_end;
+    read_array(p, token_type, header.token_num);
+    p += pad4(header.token_num);
+    p = read_array(p, token_end, header.token_num);
+    const char *text = p;
+
+    // the checksum only finds broken files, the ids are checked too, so a bad file never makes the Analyzer crash
+    bool ok = ast.kind[0] == (uint8_t)NodeType::COMPUINT;
+    for (size_t i = 0; i < n && ok; i++)
+    {
+        ok = ast.kind[i] <= (uint8_t)NodeType::CONSTEXP &&
+             (ast.kind[i] == (uint8_t)NodeType::TERMINAL ? ast.token[i] < header.token_num : ast.token[i] == FlatAst::NONE) &&
+             (ast.first_child[i] == FlatAst::NONE ? ast.child_count[i] == 0
+                                                  : ast.first_child[i] > i && ast.child_count[i] <= n - ast.first_child[i]) &&
+             (ast.next_sibling[i] == FlatAst::NONE || ast.next_sibling[i] == i + 1);
+    }
+    ast.tokens.resize(header.token_num);
+    for (size_t i = 0, begin = 0; i < header.token_num && ok; begin = token_end[i], i++)
+    {
+        ok = token_type[i] <= (uint8_t)TokenType::ENDTK && begin <= token_end[i] && token_end[i] <= header.text_size;
+        if (ok)
+            ast.tokens[i] = {(TokenType)token_type[i], ir::Symbol(text + begin, token_end[i] - begin)};
+    }
+    if (!ok)
+    {
+        ast = FlatAst();
+        return false;
+    }
+    ast.reset_attributes();
+    return true;
+}
+
+bool AstCache::save(const FlatAst &ast) const
+{
+    if (!valid || ast.size() == 0 || ast.size() >= FlatAst::NONE)
+        return false;
+
+    std::vector<uint8_t> token_type(ast.tokens.size());
+    std::vector<uint32_t> token_end(ast.tokens.size());
+    std::string text;
+    for (size_t i = 0; i < ast.tokens.size(); i++)
+    {
+        token_type[i] = (uint8_t)ast.tokens[i].type;
+        text += ast.tokens[i].value.str();
+        token_end[i] = text.size();
+    }
+
+    std::string content;
+    content.reserve(cache_content_size(ast.size(), ast.tokens.size(), text.size()));
+    append_array(content, ast.kind);
+    content.resize(pad4(content.size()));
+    append_array(content, ast.token);
+    append_array(content, ast.first_child);
+    append_array(content, ast.next_sibling);
+    append_array(content, ast.child_count);
+    append_array(content, token_type);
+    content.resize(pad4(content.size()));
+    append_array(content, token_end);
+    content += text;
+    assert(content.size() == cache_content_size(ast.size(), ast.tokens.size(), text.size()));
+
+    AstCacheHeader header = {AST_CACHE_MAGIC, AST_CACHE_VERSION, source_hash, source_size,
+                             (uint32_t)ast.size(), (uint32_t)ast.tokens.size(), (uint32_t)text.size(), 0,
+                             hash_bytes(content.data(), content.size())};
+
+    // 先写入临时文件再重命名, 同时运行的编译器只会看到完整的缓存文件
+    std::string tmp_path = path + ".tmp" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            return false;
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(content.data(), content.size());
+        if (!file.good())
+        {
+            file.close();
+            std::remove(tmp_path.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0)
+    {
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+#ifdef DEBUG_AST_CACHE
+#include "front/syntax.h"
+#include <iostream>
+
+// compare a cold run, which scans, parses and saves the file, with a warm run, which loads the cache file
+void bench_ast_cache(const std::string &dir, const std::string &filename)
+{
+    const int rounds = 5;
+    double cold_ms = 0, save_ms = 0, warm_ms = 0;
+    AstCache cache(dir, filename);
+    FlatAst cold;
+    for (int i = 0; i < rounds; i++)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        frontend::Scanner scanner(filename);
+        frontend::Parser parser(scanner);
+        cold = FlatAst();
+        parser.get_flat_abstract_syntax_tree(cold);
+        auto parsed = std::chrono::steady_clock::now();
+        assert(cache.save(cold));
+        auto saved = std::chrono::steady_clock::now();
+        cold_ms += std::chrono::duration<double, std::milli>(parsed - begin).count();
+        save_ms += std::chrono::duration<double, std::milli>(saved - parsed).count();
+    }
+    for (int i = 0; i < rounds; i++)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        FlatAst warm;
+        assert(cache.load(warm));
+        warm_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        assert(warm.kind == cold.kind && warm.token == cold.token && warm.first_child == cold.first_child &&
+               warm.next_sibling == cold.next_sibling && warm.child_count == cold.child_count && warm.v == cold.v &&
+               warm.t == cold.t && warm.is_computable == cold.is_computable && "in bench_ast_cache, loaded AST differs");
+        for (size_t j = 0; j < cold.tokens.size(); j++)
+            assert(warm.tokens[j].type == cold.tokens[j].type && warm.tokens[j].value == cold.tokens[j].value &&
+                   "in bench_ast_cache, loaded token differs");
+    }
+    std::cout << "ast cache: " << cold.size() << " nodes, scan and parse " << cold_ms / rounds << " ms, save "
+              << save_ms / rounds << " ms, load " << warm_ms / rounds << " ms" << std::endl;
+}
+#endif
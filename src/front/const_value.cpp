@@ -0,0 +1,194 @@
+#include "front/const_value.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+using frontend::ConstValue;
+using frontend::TokenType;
+
+ConstValue::ConstValue() : t(ir::Type::IntLiteral), i(0) {}
+
+ConstValue ConstValue::of_int(int32_t v)
+{
+    ConstValue value;
+    value.t = ir::Type::IntLiteral;
+    value.i = v;
+    return value;
+}
+
+ConstValue ConstValue::of_float(float v)
+{
+    ConstValue value;
+    value.t = ir::Type::FloatLiteral;
+    value.f = v;
+    return value;
+}
+
+ConstValue ConstValue::of_token(const Token &token)
+{
+    const std::string &text = token.value.str();
+    if (token.type == TokenType::FLOATLTR)
+        return of_float(std::strtof(text.c_str(), nullptr));
+    assert(token.type == TokenType::INTLTR && "in ConstValue::of_token, not a literal");
+
+    // 0x 十六进制, 0b 二进制, 0 开头为八进制; 超出 32 位的部分被截断, 2147483648 取负后为 INT_MIN
+    int base = 10;
+    size_t begin = 0;
+    if (text.size() > 1 && text[0] == '0')
+    {
+        if (text[1] == 'x' || text[1] == 'X')
+            base = 16, begin = 2;
+        else if (text[1] == 'b' || text[1] == 'B')
+            base = 2, begin = 2;
+        else
+            base = 8, begin = 1;
+    }
+    return of_int((int32_t)(uint32_t)std::strtoull(text.c_str() + begin, nullptr, base));
+}
+
+ConstValue ConstValue::of_operand(const ir::Operand &op)
+{
+    assert(is_literal(op.type) && "in ConstValue::of_operand, not a literal");
+    if (op.name.is_literal())
+        return op.name.is_float_literal() ? of_float(op.name.float_value()) : of_int(op.name.int_value());
+    // float 字面量保留了源代码中的文本
+    const std::string &text = op.name.str();
+    if (op.type == ir::Type::FloatLiteral)
+        return of_float(std::strtof(text.c_str(), nullptr));
+    return of_int((int32_t)std::strtoll(text.c_str(), nullptr, 0));
+}
+
+int32_t ConstValue::to_int() const
+{
+    return is_float() ? (int32_t)f : i;
+}
+
+float ConstValue::to_float() const
+{
+    return is_float() ? f : (float)i;
+}
+
+ConstValue ConstValue::cast(ir::Type type) const
+{
+    assert((type == ir::Type::IntLiteral || type == ir::Type::FloatLiteral) && "in ConstValue::cast, not a literal type");
+    return type == ir::Type::IntLiteral ? of_int(to_int()) : of_float(to_float());
+}
+
+uint32_t ConstValue::bits() const
+{
+    uint32_t word;
+    if (is_float())
+        memcpy(&word, &f, sizeof(word));
+    else
+        word = (uint32_t)i;
+    return word;
+}
+
+bool ConstValue::is_zero() const
+{
+    return bits() == 0;
+}
+
+ir::Symbol ConstValue::to_symbol() const
+{
+    return is_float() ? ir::Symbol::float_literal(f) : ir::Symbol::int_literal(i);
+}
+
+ConstValue frontend::fold_binary(TokenType op, ConstValue a, ConstValue b)
+{
+    // int 与 float 运算时 int 转为 float
+    if (a.is_float() != b.is_float())
+    {
+        a = a.cast(ir::Type::FloatLiteral);
+        b = b.cast(ir::Type::FloatLiteral);
+    }
+    if (a.is_float())
+    {
+        switch (op)
+        {
+        case TokenType::PLUS:
+            return ConstValue::of_float(a.f + b.f);
+        case TokenType::MINU:
+            return ConstValue::of_float(a.f - b.f);
+        case TokenType::MULT:
+            return ConstValue::of_float(a.f * b.f);
+        case TokenType::DIV:
+            return ConstValue::of_float(a.f / b.f);
+        case TokenType::MOD:
+            return ConstValue::of_float(std::fmod(a.f, b.f));
+        case TokenType::LSS:
+            return ConstValue::of_int(a.f < b.f);
+        case TokenType::LEQ:
+            return ConstValue::of_int(a.f <= b.f);
+        case TokenType::GTR:
+            return ConstValue::of_int(a.f > b.f);
+        case TokenType::GEQ:
+            return ConstValue::of_int(a.f >= b.f);
+        case TokenType::EQL:
+            return ConstValue::of_int(a.f == b.f);
+        case TokenType::NEQ:
+            return ConstValue::of_int(a.f != b.f);
+        case TokenType::AND:
+            return ConstValue::of_int(a.f != 0 && b.f != 0);
+        case TokenType::OR:
+            return ConstValue::of_int(a.f != 0 || b.f != 0);
+        default:
+            assert(0 && "in fold_binary, not a binary operator");
+        }
+    }
+
+    // 加减乘按无符号数计算, 溢出时回绕而不是未定义行为
+    uint32_t x = a.i, y = b.i;
+    switch (op)
+    {
+    case TokenType::PLUS:
+        return ConstValue::of_int((int32_t)(x + y));
+    case TokenType::MINU:
+        return ConstValue::of_int((int32_t)(x - y));
+    case TokenType::MULT:
+        return ConstValue::of_int((int32_t)(x * y));
+    case TokenType::DIV:
+        assert(b.i != 0 && "in fold_binary, division by zero");
+        return ConstValue::of_int(b.i == -1 ? (int32_t)(0u - x) : a.i / b.i);
+    case TokenType::MOD:
+        assert(b.i != 0 && "in fold_binary, division by zero");
+        return ConstValue::of_int(b.i == -1 ? 0 : a.i % b.i);
+    case TokenType::LSS:
+        return ConstValue::of_int(a.i < b.i);
+    case TokenType::LEQ:
+        return ConstValue::of_int(a.i <= b.i);
+    case TokenType::GTR:
+        return ConstValue::of_int(a.i > b.i);
+    case TokenType::GEQ:
+        return ConstValue::of_int(a.i >= b.i);
+    case TokenType::EQL:
+        return ConstValue::of_int(a.i == b.i);
+    case TokenType::NEQ:
+        return ConstValue::of_int(a.i != b.i);
+    case TokenType::AND:
+        return ConstValue::of_int(a.i && b.i);
+    case TokenType::OR:
+        return ConstValue::of_int(a.i || b.i);
+    default:
+        assert(0 && "in fold_binary, not a binary operator");
+    }
+    return a;
+}
+
+ConstValue frontend::fold_unary(TokenType op, ConstValue a)
+{
+    switch (op)
+    {
+    case TokenType::PLUS:
+        return a;
+    case TokenType::MINU:
+        return a.is_float() ? ConstValue::of_float(-a.f) : ConstValue::of_int((int32_t)(0u - (uint32_t)a.i));
+    case TokenType::NOT:
+        return ConstValue::of_int(a.is_float() ? a.f == 0 : a.i == 0);
+    default:
+        assert(0 && "in fold_unary, not an unary operator");
+    }
+    return a;
+}
@@ -0,0 +1,296 @@
+#include "front/flat_ast.h"
+
+#include <cassert>
+#include <algorithm>
+
+// #define DEBUG_JSON_WRITER
+
+#define JSON_BUFFER_SIZE (1 << 16)
+#define JSON_INDENT_SIZE 3
+
+using frontend::AstNode;
+using frontend::CompUnit;
+using frontend::ConstValue;
+using frontend::FlatAst;
+using frontend::FlatNode;
+using frontend::NodeId;
+using frontend::NodeType;
+using frontend::Term;
+using frontend::Token;
+
+const NodeId FlatAst::NONE;
+
+FlatAst::FlatAst() {}
+
+FlatAst::FlatAst(const CompUnit *root)
+{
+    copy_subtree(root, add_node(NodeType::COMPUINT));
+}
+
+NodeId FlatAst::add_node(NodeType type)
+{
+    NodeId id = kind.size();
+    kind.push_back(0);
+    token.push_back(NONE);
+    first_child.push_back(NONE);
+    next_sibling.push_back(NONE);
+    child_count.push_back(0);
+    v.push_back(ir::Symbol());
+    t.push_back(ir::Type::Int);
+    is_computable.push_back(0);
+    c.push_back(ConstValue());
+    set_type(id, type);
+    return id;
+}
+
+void FlatAst::set_type(NodeId id, NodeType type)
+{
+    kind[id] = (uint8_t)type;
+    // 与 AstNode 子类的默认值相同, 只有 Number 和 ConstExp 一开始就是可以化简为常数的
+    is_computable[id] = type == NodeType::NUMBER || type == NodeType::CONSTEXP;
+}
+
+void FlatAst::reset_attributes()
+{
+    v.assign(size(), ir::Symbol());
+    t.assign(size(), ir::Type::Int);
+    is_computable.assign(size(), 0);
+    c.assign(size(), ConstValue());
+    for (NodeId id = 0; id < size(); id++)
+        set_type(id, type_of(id));
+}
+
+NodeId FlatAst::add_children(NodeId parent, uint32_t n)
+{
+    assert(child_count[parent] == 0 && "in FlatAst::add_children, the node already has children");
+    NodeId first = kind.size();
+    for (uint32_t i = 0; i < n; i++)
+    {
+        add_node(NodeType::TERMINAL);
+        if (i + 1 < n)
+            next_sibling[first + i] = first + i + 1;
+    }
+    first_child[parent] = n ? first : NONE;
+    child_count[parent] = n;
+    return first;
+}
+
+void FlatAst::copy_subtree(const AstNode *root, NodeId root_id)
+{
+    assert(kind[root_id] == (uint8_t)root->type && "in FlatAst::copy_subtree, node type differs");
+    // nodes are visited in preorder with a stack instead of recursion, so a long LOrExp or CompUnit chain does not
+    // use the native stack, the children of a node are added before their subtrees, so they are consecutive
+    std::vector<std::pair<const AstNode *, NodeId>> stack = {{root, root_id}};
+    while (!stack.empty())
+    {
+        const AstNode *node = stack.back().first;
+        NodeId id = stack.back().second;
+        stack.pop_back();
+        if (node->type == NodeType::TERMINAL)
+        {
+            token[id] = tokens.size();
+            tokens.push_back(static_cast<const Term *>(node)->token);
+            continue;
+        }
+        uint32_t n = node->children.size();
+        if (n == 0)
+            continue;
+        NodeId first = add_children(id, n);
+        for (uint32_t i = 0; i < n; i++)
+            set_type(first + i, node->children[i]->type);
+        for (uint32_t i = n; i-- > 0;)
+            stack.push_back({node->children[i], first + i});
+    }
+}
+
+void FlatAst::resize(size_t node_num, size_t token_num)
+{
+    assert(node_num >= size() && token_num >= tokens.size() && "in FlatAst::resize, nodes can not be removed");
+    kind.resize(node_num, (uint8_t)NodeType::TERMINAL);
+    token.resize(node_num, NONE);
+    first_child.resize(node_num, NONE);
+    next_sibling.resize(node_num, NONE);
+    child_count.resize(node_num, 0);
+    v.resize(node_num, ir::Symbol());
+    t.resize(node_num, ir::Type::Int);
+    is_computable.resize(node_num, 0);
+    c.resize(node_num, ConstValue());
+    tokens.resize(token_num, {TokenType::ENDTK, ir::Symbol()});
+}
+
+void FlatAst::copy_part(NodeId id, NodeId base, uint32_t token_base, const FlatAst &part)
+{
+    assert(part.size() > 0 && base + part.size() - 1 <= size() && token_base + part.tokens.size() <= tokens.size() &&
+           "in FlatAst::copy_part, the nodes are not added");
+    auto map_node = [&](NodeId k)
+    { return k == NONE ? NONE : (k == 0 ? id : base + k - 1); };
+    auto map_token = [&](uint32_t k)
+    { return k == NONE ? NONE : token_base + k; };
+    for (NodeId k = 0; k < part.size(); k++)
+    {
+        NodeId i = map_node(k);
+        kind[i] = part.kind[k];
+        token[i] = map_token(part.token[k]);
+        first_child[i] = map_node(part.first_child[k]);
+        if (k > 0)
+            next_sibling[i] = map_node(part.next_sibling[k]);
+        child_count[i] = part.child_count[k];
+        v[i] = part.v[k];
+        t[i] = part.t[k];
+        is_computable[i] = part.is_computable[k];
+        c[i] = part.c[k];
+    }
+    std::copy(part.tokens.begin(), part.tokens.end(), tokens.begin() + token_base);
+}
+
+size_t FlatAst::size() const
+{
+    return kind.size();
+}
+
+size_t FlatAst::bytes_used() const
+{
+    return size() * (sizeof(uint8_t) + sizeof(uint32_t) + 2 * sizeof(NodeId) + sizeof(uint32_t) + sizeof(ir::Symbol) + sizeof(ir::Type) + sizeof(uint8_t) + sizeof(ConstValue)) +
+           tokens.size() * sizeof(Token);
+}
+
+NodeType FlatAst::type_of(NodeId id) const
+{
+    return (NodeType)kind[id];
+}
+
+const Token &FlatAst::token_of(NodeId id) const
+{
+    static const Token empty = {TokenType::ENDTK, ir::Symbol()};
+    return token[id] == NONE ? empty : tokens[token[id]];
+}
+
+FlatNode FlatAst::get_node(NodeId id)
+{
+    return FlatNode(*this, id);
+}
+
+void FlatAst::get_json_output(Json::Value &root, NodeId id) const
+{
+    root["name"] = toString(type_of(id));
+    if (type_of(id) == NodeType::TERMINAL)
+    {
+        root["type"] = toString(token_of(id).type);
+        root["value"] = token_of(id).value.str();
+    }
+    else
+    {
+        root["subtree"] = Json::Value();
+        for (NodeId child = first_child[id]; child != NONE; child = next_sibling[child])
+        {
+            Json::Value tmp;
+            get_json_output(tmp, child);
+            root["subtree"].append(tmp);
+        }
+    }
+}
+
+// quote a string like Json::StyledWriter, most names and token values need no escaping
+void append_json_string(std::string &buf, const std::string &str)
+{
+    for (unsigned char c : str)
+        if (c == '"' || c == '\\' || c < 0x20 || c >= 0x80)
+        {
+            buf += Json::valueToQuotedString(str.c_str());
+            return;
+        }
+    buf += '"';
+    buf += str;
+    buf += '"';
+}
+
+void FlatAst::write_json(std::ostream &out) const
+{
+#ifdef DEBUG_JSON_WRITER
+    std::string text; // all text written, to check with Json::StyledWriter
+#endif
+    std::string buf;
+    buf.reserve(JSON_BUFFER_SIZE);
+    // a node of depth d is an object indented by 2 * d levels, its members are indented by 2 * d + 1 levels
+    std::vector<NodeId> path; // the ancestors of id, whose subtree arrays are not closed yet
+    NodeId id = 0;
+    while (true)
+    {
+        size_t indent = path.size() * 2 * JSON_INDENT_SIZE;
+        buf += "{\n";
+        buf.append(indent + JSON_INDENT_SIZE, ' ');
+        buf += "\"name\" : ";
+        append_json_string(buf, toString(type_of(id)));
+        buf += ",\n";
+        buf.append(indent + JSON_INDENT_SIZE, ' ');
+        if (type_of(id) == NodeType::TERMINAL)
+        {
+            buf += "\"type\" : ";
+            append_json_string(buf, toString(token_of(id).type));
+            buf += ",\n";
+            buf.append(indent + JSON_INDENT_SIZE, ' ');
+            buf += "\"value\" : ";
+            append_json_string(buf, token_of(id).value.str());
+        }
+        else if (first_child[id] == NONE)
+        {
+            buf += "\"subtree\" : null";
+        }
+        else
+        {
+            buf += "\"subtree\" : [\n";
+            buf.append(indent + 2 * JSON_INDENT_SIZE, ' ');
+            path.push_back(id);
+            id = first_child[id];
+            continue;
+        }
+        buf += '\n';
+        buf.append(indent, ' ');
+        buf += '}';
+
+        // close the subtrees whose last child is written
+        while (!path.empty() && next_sibling[id] == NONE)
+        {
+            id = path.back();
+            path.pop_back();
+            indent = path.size() * 2 * JSON_INDENT_SIZE;
+            buf += '\n';
+            buf.append(indent + JSON_INDENT_SIZE, ' ');
+            buf += "]\n";
+            buf.append(indent, ' ');
+            buf += '}';
+        }
+        if (path.empty())
+            break;
+        buf += ",\n";
+        buf.append(path.size() * 2 * JSON_INDENT_SIZE, ' ');
+        id = next_sibling[id];
+
+        if (buf.size() >= JSON_BUFFER_SIZE)
+        {
+            out.write(buf.data(), buf.size());
+#ifdef DEBUG_JSON_WRITER
+            text += buf;
+#endif
+            buf.clear();
+        }
+    }
+    buf += '\n';
+    out.write(buf.data(), buf.size());
+
+#ifdef DEBUG_JSON_WRITER
+    text += buf;
+    Json::Value root;
+    get_json_output(root);
+    assert(Json::StyledWriter().write(root) == text && "in FlatAst::write_json, text differs from Json::StyledWriter");
+#endif
+}
+
+FlatNode::FlatNode(FlatAst &ast, NodeId id)
+    : id(id), type(ast.type_of(id)), children({ast.first_child[id], ast.child_count[id]}),
+      v(ast.v[id]), arr_name(ast.v[id]), n(ast.v[id]), t(ast.t[id]), is_computable(ast.is_computable[id]),
+      c(ast.c[id]), token(ast.token_of(id)), op(TokenType::ENDTK)
+{
+    if (type == NodeType::UNARYOP && children.size())
+        op = ast.token_of(children[0]).type;
+}
@@ -0,0 +1,278 @@
+#include "front/incremental.h"
+#include "front/syntax.h"
+
+#include <cassert>
+#include <chrono>
+#include <sstream>
+#include <algorithm>
+
+// #define DEBUG_INCREMENTAL
+
+using frontend::AstNode;
+using frontend::CompUnit;
+using frontend::EditReport;
+using frontend::IncrementalFrontend;
+using frontend::Token;
+using frontend::TokenView;
+
+double elapsed_ms(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+
+// every token consumed by Parser is a Term, so the number of Terms is the number of tokens of a node
+uint32_t count_terms(const AstNode *node)
+{
+    if (node->type == frontend::NodeType::TERMINAL)
+        return 1;
+    uint32_t cnt = 0;
+    for (auto child : node->children)
+        cnt += count_terms(child);
+    return cnt;
+}
+
+// split a CompUnit chain into its Decl and FuncDef, the CompUnit nodes are dropped
+void take_items(CompUnit *root, std::vector<AstNode *> &items)
+{
+    for (AstNode *node = root; node; node = node->children.size() > 1 ? node->children[1] : nullptr)
+        if (node->children.size() > 0)
+            items.push_back(node->children[0]);
+}
+
+double EditReport::saved_ms() const
+{
+    return full_ms - incremental_ms;
+}
+
+std::string EditReport::to_string() const
+{
+    std::ostringstream out;
+    out << "edit: " << relexed_tokens << " tokens scanned, " << reparsed_items << " items parsed"
+        << (full_rebuild ? " (full rebuild)" : "") << ", " << incremental_ms << " ms, full rebuild " << full_ms
+        << " ms, saved " << saved_ms() << " ms";
+    return out.str();
+}
+
+IncrementalFrontend::IncrementalFrontend(const std::string &text)
+    : source(text), tokens(), arena(), rebuild_bytes(0), units(), items(), item_begin(), full_ms(0)
+{
+    rebuild();
+}
+
+IncrementalFrontend::~IncrementalFrontend() {}
+
+CompUnit *IncrementalFrontend::get_abstract_syntax_tree() const
+{
+    return units[0];
+}
+
+const std::vector<TokenView> &IncrementalFrontend::get_tokens() const
+{
+    return tokens;
+}
+
+const std::string &IncrementalFrontend::get_source() const
+{
+    return source;
+}
+
+void IncrementalFrontend::rebuild()
+{
+    auto begin = std::chrono::steady_clock::now();
+    assert(source.size() < UINT32_MAX && "in IncrementalFrontend, source is too large");
+
+    tokens.clear();
+    DFA dfa;
+    TokenView tk;
+    bool in_comment = false;
+    uint32_t pos = 0;
+    while (scan_token(source.data(), source.size(), pos, in_comment, dfa, tk))
+        tokens.push_back(tk);
+    if (dfa.finish(source.data(), source.size(), tk))
+        tokens.push_back(tk);
+
+    units.clear();
+    items.clear();
+    arena.reset();
+    // tokens which can not be parsed are left after the last item, like Parser::get_abstract_syntax_tree() does
+    parse_items(0, tokens.size(), items);
+    item_begin.assign(1, 0);
+    for (auto item : items)
+        item_begin.push_back(item_begin.back() + count_terms(item));
+    relink(0);
+
+    rebuild_bytes = arena.bytes_used();
+    full_ms = elapsed_ms(begin);
+}
+
+bool IncrementalFrontend::parse_items(uint32_t begin, uint32_t end, std::vector<AstNode *> &parsed)
+{
+    std::vector<Token> slice(end - begin);
+    for (uint32_t i = begin; i < end; i++)
+    {
+        slice[i - begin].type = tokens[i].type;
+        slice[i - begin].value = ir::Symbol(source.data() + tokens[i].offset, tokens[i].length);
+    }
+    Parser parser(slice, &arena);
+    CompUnit *root = arena.create<CompUnit>();
+    parser.parseCompUnit(root);
+    take_items(root, parsed);
+    return parser.token_stream.peek().type == TokenType::ENDTK;
+}
+
+void IncrementalFrontend::relink(uint32_t from)
+{
+    // there is always a root, even if there is no item
+    size_t unit_num = std::max(items.size(), (size_t)1);
+    while (units.size() < unit_num)
+        units.push_back(arena.create<CompUnit>());
+    units.resize(unit_num);
+    for (size_t i = from; i < units.size(); i++)
+    {
+        units[i]->children.clear();
+        if (i < items.size())
+        {
+            units[i]->children.push_back(items[i]);
+            items[i]->parent = units[i];
+        }
+        if (i + 1 < units.size())
+        {
+            units[i]->children.push_back(units[i + 1]);
+            units[i + 1]->parent = units[i];
+        }
+    }
+    units[0]->parent = nullptr;
+}
+
+EditReport IncrementalFrontend::apply_edit(uint32_t begin, uint32_t end, const std::string &text)
+{
+    assert(begin <= end && end <= source.size() && "in IncrementalFrontend::apply_edit, invalid edit range");
+    auto start_time = std::chrono::steady_clock::now();
+    EditReport report = {0, 0, false, 0, full_ms};
+
+    // tokens before first end before the edit, their next characters are not changed, so they are not changed,
+    // and the DFA is empty at the end of tokens[first - 1]
+    uint32_t first = std::lower_bound(tokens.begin(), tokens.end(), begin, [](const TokenView &tk, uint32_t pos)
+                                      { return tk.offset + tk.length < pos; }) -
+                     tokens.begin();
+    uint32_t pos = first ? tokens[first - 1].offset + tokens[first - 1].length : 0;
+    int64_t delta = (int64_t)text.size() - (end - begin);
+    source.replace(begin, end - begin, text);
+    assert(source.size() < UINT32_MAX && "in IncrementalFrontend, source is too large");
+    uint32_t new_end = begin + text.size();
+
+    // scan until a token after the edit is the same as an old one, the tokens after it are the same as old ones too
+    std::vector<TokenView> relexed;
+    DFA dfa;
+    TokenView tk;
+    bool in_comment = false;
+    uint32_t last = first; // the first old token which is not replaced
+    bool synced = false;
+    while (scan_token(source.data(), source.size(), pos, in_comment, dfa, tk))
+    {
+        if (tk.offset >= new_end)
+        {
+            int64_t old_offset = (int64_t)tk.offset - delta;
+            while (last < tokens.size() && tokens[last].offset < old_offset)
+                last++;
+            if (last < tokens.size() && tokens[last].offset == old_offset && tokens[last].type == tk.type && tokens[last].length == tk.length)
+            {
+                synced = true;
+                break;
+            }
+        }
+        relexed.push_back(tk);
+    }
+    if (!synced)
+    {
+        if (dfa.finish(source.data(), source.size(), tk))
+            relexed.push_back(tk);
+        last = tokens.size();
+    }
+    report.relexed_tokens = relexed.size();
+
+    // old tokens [lo, hi) are replaced by new tokens [lo, lo + cnt), the same tokens at both ends are not counted
+    uint32_t lo = first, hi = last, relexed_lo = 0, relexed_hi = relexed.size();
+    while (lo < hi && relexed_lo < relexed_hi && tokens[lo].offset + tokens[lo].length <= begin &&
+           tokens[lo].offset == relexed[relexed_lo].offset && tokens[lo].type == relexed[relexed_lo].type && tokens[lo].length == relexed[relexed_lo].length)
+        lo++, relexed_lo++;
+    while (lo < hi && relexed_lo < relexed_hi && relexed[relexed_hi - 1].offset >= new_end &&
+           tokens[hi - 1].offset + delta == relexed[relexed_hi - 1].offset && tokens[hi - 1].type == relexed[relexed_hi - 1].type &&
+           tokens[hi - 1].length == relexed[relexed_hi - 1].length)
+        hi--, relexed_hi--;
+    uint32_t cnt = relexed_hi - relexed_lo;
+    int64_t token_delta = (int64_t)cnt - (hi - lo);
+
+    tokens.erase(tokens.begin() + lo, tokens.begin() + hi);
+    tokens.insert(tokens.begin() + lo, relexed.begin() + relexed_lo, relexed.begin() + relexed_hi);
+    for (size_t i = lo + cnt; i < tokens.size(); i++)
+        tokens[i].offset += delta;
+
+    if (lo == hi && cnt == 0)
+    {
+        // only spaces or comments are changed
+    }
+    else if (items.empty() || hi > item_begin.back())
+    {
+        // the tokens which can not be parsed are changed
+        report.full_rebuild = true;
+    }
+    else
+    {
+        // items [a, b) contain the changed tokens, if tokens are inserted between two items, the latter is parsed again
+        uint32_t a = std::upper_bound(item_begin.begin(), item_begin.begin() + items.size(), lo) - item_begin.begin() - 1;
+        uint32_t b = std::upper_bound(item_begin.begin(), item_begin.begin() + items.size(), std::max(hi, lo + 1) - 1) - item_begin.begin();
+        std::vector<AstNode *> parsed;
+        if (!parse_items(item_begin[a], item_begin[b] + token_delta, parsed))
+        {
+            report.full_rebuild = true;
+        }
+        else
+        {
+            std::vector<uint32_t> parsed_begin;
+            uint32_t item_pos = item_begin[a];
+            for (auto item : parsed)
+            {
+                parsed_begin.push_back(item_pos);
+                item_pos += count_terms(item);
+            }
+            items.erase(items.begin() + a, items.begin() + b);
+            items.insert(items.begin() + a, parsed.begin(), parsed.end());
+            item_begin.erase(item_begin.begin() + a, item_begin.begin() + b);
+            for (size_t i = a; i < item_begin.size(); i++)
+                item_begin[i] += token_delta;
+            item_begin.insert(item_begin.begin() + a, parsed_begin.begin(), parsed_begin.end());
+            relink(a ? a - 1 : 0);
+            report.reparsed_items = parsed.size();
+        }
+    }
+
+    // the replaced nodes are not freed by the arena, so the AST is built again if they take most of it
+    if (!report.full_rebuild && arena.bytes_used() > 4 * rebuild_bytes + AstArena::BLOCK_SIZE)
+        report.full_rebuild = true;
+    if (report.full_rebuild)
+    {
+        rebuild();
+        report.relexed_tokens = tokens.size();
+        report.reparsed_items = items.size();
+        report.full_ms = full_ms;
+    }
+    report.incremental_ms = elapsed_ms(start_time);
+
+#ifdef DEBUG_INCREMENTAL
+#include <iostream>
+    // check with a full rebuild, and report the time it really takes
+    IncrementalFrontend full(source);
+    assert(full.tokens.size() == tokens.size() && "in IncrementalFrontend, token number differs from full rebuild");
+    for (size_t i = 0; i < tokens.size(); i++)
+        assert(full.tokens[i].type == tokens[i].type && full.tokens[i].offset == tokens[i].offset && full.tokens[i].length == tokens[i].length &&
+               "in IncrementalFrontend, token differs from full rebuild");
+    Json::Value full_json, json;
+    full.get_abstract_syntax_tree()->get_json_output(full_json);
+    get_abstract_syntax_tree()->get_json_output(json);
+    assert(full_json == json && "in IncrementalFrontend, AST differs from full rebuild");
+    report.full_ms = full.full_ms;
+    std::cout << report.to_string() << std::endl;
+#endif
+    return report;
+}
@@ -1,14 +1,31 @@
 #include "front/lexical.h"
+#include "front/lexical_simd.h"
 
 #include <map>
 #include <cassert>
 #include <string>
+#include <cstring>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 #define TODO assert(0 && "todo")
 
 // #define DEBUG_DFA_BEGIN
 // #define DEBUG_DFA_END
 // #define DEBUG_SCANNER
+// #define DEBUG_DFA_TABLE
+// #define DEBUG_KEYWORD_BENCH
+// #define DEBUG_PARALLEL_SCAN
 
 std::string frontend::toString(State s)
 {
@@ -33,42 +50,76 @@ std::string frontend::toString(State s)
 std::set<std::string> frontend::keywords = {
     "const", "int", "float", "if", "else", "while", "continue", "break", "return", "void"};
 
-frontend::DFA::DFA() : cur_state(frontend::State::Empty), cur_str() {}
+struct Keyword
+{
+    const char *word;
+    uint8_t len;
+    frontend::TokenType type;
+};
 
-frontend::DFA::~DFA() {}
+constexpr Keyword keyword_list[] = {
+    {"const", 5, frontend::TokenType::CONSTTK},
+    {"int", 3, frontend::TokenType::INTTK},
+    {"float", 5, frontend::TokenType::FLOATTK},
+    {"if", 2, frontend::TokenType::IFTK},
+    {"else", 4, frontend::TokenType::ELSETK},
+    {"while", 5, frontend::TokenType::WHILETK},
+    {"continue", 8, frontend::TokenType::CONTINUETK},
+    {"break", 5, frontend::TokenType::BREAKTK},
+    {"return", 6, frontend::TokenType::RETURNTK},
+    {"void", 4, frontend::TokenType::VOIDTK}};
 
-frontend::TokenType get_keywords_type(std::string s)
-{
-    // std::cout << "get_keywords_type:" << s << std::endl;
-    if (s == "const")
-        return frontend::TokenType::CONSTTK;
-    else if (s == "int")
-        return frontend::TokenType::INTTK;
-    else if (s == "float")
-        return frontend::TokenType::FLOATTK;
-    else if (s == "if")
-        return frontend::TokenType::IFTK;
-    else if (s == "else")
-        return frontend::TokenType::ELSETK;
-    else if (s == "while")
-        return frontend::TokenType::WHILETK;
-    else if (s == "continue")
-        return frontend::TokenType::CONTINUETK;
-    else if (s == "break")
-        return frontend::TokenType::BREAKTK;
-    else if (s == "return")
-        return frontend::TokenType::RETURNTK;
-    else if (s == "void")
-        return frontend::TokenType::VOIDTK;
-    else
+constexpr uint32_t KEYWORD_HASH_SIZE = 32;
+constexpr uint32_t KEYWORD_MIN_LEN = 2;
+constexpr uint32_t KEYWORD_MAX_LEN = 8;
+
+// the hash is collision free on keyword_list, so one comparison decides whether a string is a keyword
+constexpr uint32_t keyword_hash(const char *str, uint32_t len)
+{
+    return (len + (unsigned char)str[0] + (unsigned char)str[len - 1]) & (KEYWORD_HASH_SIZE - 1);
+}
+
+struct KeywordTable
+{
+    int8_t index[KEYWORD_HASH_SIZE]; // hash -> index in keyword_list, -1 if no keyword
+    bool perfect;                    // true if no two keywords have the same hash
+};
+
+constexpr KeywordTable build_keyword_table()
+{
+    KeywordTable t{};
+    t.perfect = true;
+    for (uint32_t i = 0; i < KEYWORD_HASH_SIZE; i++)
+        t.index[i] = -1;
+    for (uint32_t i = 0; i < sizeof(keyword_list) / sizeof(Keyword); i++)
+    {
+        uint32_t h = keyword_hash(keyword_list[i].word, keyword_list[i].len);
+        if (t.index[h] != -1)
+            t.perfect = false;
+        t.index[h] = i;
+    }
+    return t;
+}
+
+constexpr KeywordTable keyword_table = build_keyword_table();
+static_assert(keyword_table.perfect, "keyword_hash has collision, change the hash or KEYWORD_HASH_SIZE");
+
+frontend::TokenType get_keywords_type(const char *str, size_t len)
+{
+    // std::cout << "get_keywords_type:" << std::string(str, len) << std::endl;
+    if (len < KEYWORD_MIN_LEN || len > KEYWORD_MAX_LEN)
         return frontend::TokenType::IDENFR;
+    int8_t i = keyword_table.index[keyword_hash(str, len)];
+    if (i >= 0 && keyword_list[i].len == len && memcmp(str, keyword_list[i].word, len) == 0)
+        return keyword_list[i].type;
+    return frontend::TokenType::IDENFR;
 }
 
-frontend::TokenType get_op_type(std::string s)
+frontend::TokenType get_op_type(const char *str, size_t len)
 {
-    if (s.size() == 1)
+    if (len == 1)
     {
-        switch (s[0])
+        switch (str[0])
         {
         case '+':
             return frontend::TokenType::PLUS;
@@ -110,25 +161,191 @@ frontend::TokenType get_op_type(std::string s)
             assert(0 && "invalid op type");
         }
     }
-    else if (s.size() == 2)
+    else if (len == 2)
+    {
+        // the first char decides the operator, the second char only needs to be checked
+        switch (str[0])
+        {
+        case '<':
+            if (str[1] == '=')
+                return frontend::TokenType::LEQ;
+            break;
+        case '>':
+            if (str[1] == '=')
+                return frontend::TokenType::GEQ;
+            break;
+        case '=':
+            if (str[1] == '=')
+                return frontend::TokenType::EQL;
+            break;
+        case '!':
+            if (str[1] == '=')
+                return frontend::TokenType::NEQ;
+            break;
+        case '&':
+            if (str[1] == '&')
+                return frontend::TokenType::AND;
+            break;
+        case '|':
+            if (str[1] == '|')
+                return frontend::TokenType::OR;
+            break;
+        }
+    }
+    assert(0 && "invalid op type");
+    return frontend::TokenType::IDENFR;
+}
+
+// every character is mapped to a class, characters in the same class always make the same transition
+enum CharClass : uint8_t
+{
+    C_OTHER,      // space, \n, \r, and other characters can not be a part of token
+    C_LETTER,     // a-z, A-Z
+    C_UNDERSCORE, // '_', it is different from letters in IntLiteral and FloatLiteral
+    C_DIGIT,      // 0-9
+    C_DOT,        // '.'
+    C_SINGLE_OP,  // operators which can not be the prefix of a compound operator
+    C_LSS,        // '<'
+    C_GTR,        // '>'
+    C_ASSIGN,     // '='
+    C_NOT,        // '!'
+    C_AND,        // '&'
+    C_OR,         // '|'
+    C_NUM
+};
+
+// the rows of the transition table, State::op is split into sub-states to remember the prefix of a compound operator
+enum Row : uint8_t
+{
+    R_EMPTY,
+    R_IDENT,
+    R_INT,
+    R_FLOAT,
+    R_OP,       // a complete single operator
+    R_LSS,      // "<", wait for '='
+    R_GTR,      // ">", wait for '='
+    R_ASSIGN,   // "=", wait for '='
+    R_NOT,      // "!", wait for '='
+    R_AND,      // "&", wait for '&'
+    R_OR,       // "|", wait for '|'
+    R_COMPOUND, // a complete compound operator
+    R_NUM
+};
+
+constexpr uint8_t EMIT = 0x80; // the flag in transition entry, means a token ends before the input character
+
+struct DFATable
+{
+    uint8_t cls[256];             // character -> CharClass
+    uint8_t trans[R_NUM][C_NUM];  // (Row, CharClass) -> next Row | EMIT
+    frontend::State state[R_NUM]; // Row -> State
+};
+
+// the row entered when an operator of class c is read
+constexpr uint8_t op_row(uint8_t c)
+{
+    return c == C_SINGLE_OP ? R_OP : c - C_LSS + R_LSS;
+}
+
+constexpr DFATable build_dfa_table()
+{
+    DFATable t{};
+    for (int c = 'a'; c <= 'z'; c++)
+        t.cls[c] = C_LETTER;
+    for (int c = 'A'; c <= 'Z'; c++)
+        t.cls[c] = C_LETTER;
+    for (int c = '0'; c <= '9'; c++)
+        t.cls[c] = C_DIGIT;
+    t.cls['_'] = C_UNDERSCORE;
+    t.cls['.'] = C_DOT;
+    const char single_ops[] = "+-*/%:;,()[]{}";
+    for (int i = 0; single_ops[i]; i++)
+        t.cls[(unsigned char)single_ops[i]] = C_SINGLE_OP;
+    t.cls['<'] = C_LSS;
+    t.cls['>'] = C_GTR;
+    t.cls['='] = C_ASSIGN;
+    t.cls['!'] = C_NOT;
+    t.cls['&'] = C_AND;
+    t.cls['|'] = C_OR;
+
+    for (int r = 0; r < R_NUM; r++)
     {
-        if (s == "<=")
-            return frontend::TokenType::LEQ;
-        else if (s == ">=")
-            return frontend::TokenType::GEQ;
-        else if (s == "==")
-            return frontend::TokenType::EQL;
-        else if (s == "!=")
-            return frontend::TokenType::NEQ;
-        else if (s == "&&")
-            return frontend::TokenType::AND;
-        else if (s == "||")
-            return frontend::TokenType::OR;
+        if (r == R_EMPTY)
+            t.state[r] = frontend::State::Empty;
+        else if (r == R_IDENT)
+            t.state[r] = frontend::State::Ident;
+        else if (r == R_INT)
+            t.state[r] = frontend::State::IntLiteral;
+        else if (r == R_FLOAT)
+            t.state[r] = frontend::State::FloatLiteral;
         else
-            assert(0 && "invalid op type");
+            t.state[r] = frontend::State::op;
+        for (int c = 0; c < C_NUM; c++)
+        {
+            bool is_op = c >= C_SINGLE_OP;
+            uint8_t next = R_EMPTY | EMIT;
+            switch (r)
+            {
+            case R_EMPTY:
+                if (c == C_LETTER || c == C_UNDERSCORE)
+                    next = R_IDENT;
+                else if (c == C_DIGIT)
+                    next = R_INT;
+                else if (c == C_DOT)
+                    next = R_FLOAT;
+                else if (is_op)
+                    next = op_row(c);
+                else
+                    next = R_EMPTY;
+                break;
+            case R_IDENT:
+                if (is_op)
+                    next = op_row(c) | EMIT;
+                else if (c == C_LETTER || c == C_UNDERSCORE || c == C_DIGIT)
+                    next = R_IDENT;
+                break;
+            case R_INT:
+                if (c == C_DOT)
+                    next = R_FLOAT;
+                else if (c == C_LETTER || c == C_DIGIT)
+                    next = R_INT;
+                else if (is_op)
+                    next = op_row(c) | EMIT;
+                break;
+            case R_FLOAT:
+                if (c == C_LETTER || c == C_DIGIT)
+                    next = R_FLOAT;
+                else if (is_op)
+                    next = op_row(c) | EMIT;
+                break;
+            default: // operators
+                if (c == C_DIGIT)
+                    next = R_INT | EMIT;
+                else if (c == C_DOT)
+                    next = R_FLOAT | EMIT;
+                else if (c == C_LETTER || c == C_UNDERSCORE)
+                    next = R_IDENT | EMIT;
+                else if (is_op)
+                {
+                    // "<=" ">=" "==" "!=" "&&" "||"
+                    bool compound = ((r == R_LSS || r == R_GTR || r == R_ASSIGN || r == R_NOT) && c == C_ASSIGN) ||
+                                    (r == R_AND && c == C_AND) || (r == R_OR && c == C_OR);
+                    next = compound ? R_COMPOUND : op_row(c) | EMIT;
+                }
+                break;
+            }
+            t.trans[r][c] = next;
+        }
     }
+    return t;
 }
 
+constexpr DFATable dfa_table = build_dfa_table();
+
+#ifdef DEBUG_DFA_TABLE
+// the predicates used by the DFA before the transition table, they are kept as a reference to check the table
+#include <iostream>
+
 bool is_letter(char c)
 {
     return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
@@ -144,70 +361,21 @@ bool is_dot(char c)
     return c == '.';
 }
 
-bool is_single_operator(std::string str)
-{
-    return (
-        str == "+" ||
-        str == "-" ||
-        str == "*" ||
-        str == "/" ||
-        str == "%" ||
-        str == ":" ||
-        str == ";" ||
-        str == "," ||
-        str == "(" ||
-        str == ")" ||
-        str == "[" ||
-        str == "]" ||
-        str == "{" ||
-        str == "}");
-}
-
-bool is_prefix_operator(char c)
+bool is_single_operator(const std::string &s)
 {
-    return (
-        c == '<' ||
-        c == '>' ||
-        c == '=' ||
-        c == '!' ||
-        c == '&' ||
-        c == '|');
+    return s == "+" || s == "-" || s == "*" || s == "/" || s == "%" || s == ":" || s == ";" ||
+           s == "," || s == "(" || s == ")" || s == "[" || s == "]" || s == "{" || s == "}";
 }
 
-bool is_compound_operator(std::string str)
+bool is_compound_operator(const std::string &s)
 {
-    return (
-        str == "<=" ||
-        str == ">=" ||
-        str == "==" ||
-        str == "!=" ||
-        str == "&&" ||
-        str == "||");
+    return s == "<=" || s == ">=" || s == "==" || s == "!=" || s == "&&" || s == "||";
 }
 
 bool is_operator(char c)
 {
-    return (
-        c == '+' ||
-        c == '-' ||
-        c == '*' ||
-        c == '/' ||
-        c == '%' ||
-        c == ':' ||
-        c == ';' ||
-        c == ',' ||
-        c == '(' ||
-        c == ')' ||
-        c == '[' ||
-        c == ']' ||
-        c == '{' ||
-        c == '}' ||
-        c == '<' ||
-        c == '>' ||
-        c == '=' ||
-        c == '!' ||
-        c == '&' ||
-        c == '|');
+    return is_single_operator(std::string(1, c)) ||
+           c == '<' || c == '>' || c == '=' || c == '!' || c == '&' || c == '|';
 }
 
 bool is_ident_composition(char c)
@@ -215,185 +383,209 @@ bool is_ident_composition(char c)
     return is_letter(c) || c == '_';
 }
 
-bool frontend::DFA::next(char input, Token &buf)
+// the transition of the old DFA, input is the current state and string, output is the next state and whether a token is produced
+bool reference_next(frontend::State state, const std::string &cur_str, char input, frontend::State &next_state)
 {
-#ifdef DEBUG_DFA_BEGIN
-#include <iostream>
-    std::cout << "in state [" << toString(cur_state) << "], input = \'" << input << "\', str = " << cur_str << "\t";
-#endif
-    bool is_token = false; // 当前字符串是否为token
-    if (cur_state == State::Empty)
+    using frontend::State;
+    next_state = state;
+    switch (state)
     {
-        // 状态转移
+    case State::Empty:
         if (is_ident_composition(input))
-            cur_state = State::Ident;
+            next_state = State::Ident;
         else if (is_digit(input))
-            cur_state = State::IntLiteral;
+            next_state = State::IntLiteral;
         else if (is_dot(input))
-            cur_state = State::FloatLiteral;
+            next_state = State::FloatLiteral;
         else if (is_operator(input))
-            cur_state = State::op;
-        else
-        {
-            reset();
-            return is_token;
-        }
-        cur_str += input;
+            next_state = State::op;
+        return false;
+    case State::Ident:
+        if (is_operator(input))
+            return next_state = State::op, true;
+        if (is_digit(input) || is_ident_composition(input))
+            return false;
+        return next_state = State::Empty, true;
+    case State::op:
+        if (is_digit(input))
+            return next_state = State::IntLiteral, true;
+        if (is_dot(input))
+            return next_state = State::FloatLiteral, true;
+        if (is_ident_composition(input))
+            return next_state = State::Ident, true;
+        if (is_operator(input))
+            return is_single_operator(cur_str) || is_compound_operator(cur_str) || !is_compound_operator(cur_str + input);
+        return next_state = State::Empty, true;
+    case State::IntLiteral:
+        if (is_dot(input))
+            return next_state = State::FloatLiteral, false;
+        if (is_letter(input) || is_digit(input))
+            return false;
+        if (is_operator(input))
+            return next_state = State::op, true;
+        return next_state = State::Empty, true;
+    case State::FloatLiteral:
+        if (is_letter(input) || is_digit(input))
+            return false;
+        if (is_operator(input))
+            return next_state = State::op, true;
+        return next_state = State::Empty, true;
     }
-    else if (cur_state == State::Ident)
+    return false;
+}
+
+// the row of the op sub-state which has read the operator string s
+uint8_t reference_op_row(const std::string &s)
+{
+    if (s.size() == 2)
+        return R_COMPOUND;
+    return op_row(dfa_table.cls[(unsigned char)s[0]]);
+}
+
+// differential check: compare the table with the old DFA on every (state, character) pair
+void check_dfa_table()
+{
+    using frontend::State;
+    struct Case
     {
-        // 状态转移
-        if (is_operator(input))
-        {
-            cur_state = State::op;
-            is_token = true;
-        }
-        else if (is_digit(input))
-        {
-            cur_state = State::Ident;
-        }
-        else if (is_ident_composition(input))
-        {
-            cur_state = State::Ident;
-        }
-        else
-        {
-            is_token = true;
-            cur_state = State::Empty;
-        }
+        uint8_t row;
+        State state;
+        std::string cur_str; // only used by State::op
+    };
+    std::vector<Case> cases = {{R_EMPTY, State::Empty, ""}, {R_IDENT, State::Ident, ""}, {R_INT, State::IntLiteral, ""}, {R_FLOAT, State::FloatLiteral, ""}};
+    for (std::string op : {"+", "-", "*", "/", "%", ":", ";", ",", "(", ")", "[", "]", "{", "}", "<", ">", "=", "!", "&", "|", "<=", ">=", "==", "!=", "&&", "||"})
+        cases.push_back({reference_op_row(op), State::op, op});
 
-        // 更新字符串
-        if (is_token)
-        {
-            buf.value = cur_str;
-            buf.type = get_keywords_type(cur_str);
-            // std::cout << "get_keywords_type:" << cur_str << std::endl;
-            cur_str = "";
-        }
-        if (cur_state != State::Empty)
-            cur_str += input;
-    }
-    else if (cur_state == State::op)
+    int error_cnt = 0;
+    for (const auto &cs : cases)
     {
-        // 状态转移
-        if (is_digit(input))
+        assert(dfa_table.state[cs.row] == cs.state);
+        for (int i = 0; i < 256; i++)
         {
-            cur_state = State::IntLiteral;
-            is_token = true;
-        }
-        else if (is_dot(input)){
-            cur_state = State::FloatLiteral;
-            is_token = true;
-        }
-        else if (is_ident_composition(input))
-        {
-            cur_state = State::Ident;
-            is_token = true;
-        }
-        else if (is_operator(input))
-        {
-            if (is_single_operator(cur_str) || is_compound_operator(cur_str) || !is_compound_operator(cur_str + input))
+            char input = (char)i;
+            State ref_state;
+            bool ref_token = reference_next(cs.state, cs.cur_str, input, ref_state);
+            uint8_t entry = dfa_table.trans[cs.row][dfa_table.cls[i]];
+            uint8_t row = entry & ~EMIT;
+            bool ok = ref_token == bool(entry & EMIT) && ref_state == dfa_table.state[row];
+            // the op sub-state should remember the right operator string
+            if (ok && ref_state == State::op)
+                ok = row == reference_op_row(ref_token || cs.state != State::op ? std::string(1, input) : cs.cur_str + input);
+            if (!ok)
             {
-                is_token = true;
+                error_cnt++;
+                std::cout << "DFA table mismatch: state [" << toString(cs.state) << "], str = " << cs.cur_str << ", input = " << i << std::endl;
             }
         }
-        else
-        {
-            is_token = true;
-            cur_state = State::Empty;
-        }
-
-        // 更新字符串
-        if (is_token)
-        {
-            buf.value = cur_str;
-            buf.type = get_op_type(cur_str);
-            cur_str = "";
-        }
-        if (cur_state != State::Empty)
-            cur_str += input;
     }
-    else if (cur_state == State::IntLiteral)
-    {
-        // 状态转移
-        if (is_dot(input))
-            cur_state = State::FloatLiteral;
-        else if (is_letter(input))
-        {
-            cur_state = State::IntLiteral;
-        }
-        else if (is_operator(input))
-        {
-            cur_state = State::op;
-            is_token = true;
-        }
-        else if (is_digit(input))
-        {
-            cur_state = State::IntLiteral;
-        }
-        else
-        {
-            is_token = true;
-            cur_state = State::Empty;
-        }
+    assert(error_cnt == 0 && "DFA table is different from the reference DFA");
+}
+#endif
 
-        // 更新字符串
-        if (is_token)
-        {
-            buf.value = cur_str;
-            buf.type = TokenType::INTLTR;
-            cur_str = "";
-        }
-        if (cur_state != State::Empty)
-            cur_str += input;
+frontend::DFA::DFA() : cur_state(R_EMPTY), cur_str(), cur_begin(0)
+{
+#ifdef DEBUG_DFA_TABLE
+    // DFAs are also constructed by scanning threads, a static local is initialized only once
+    static const bool checked = (check_dfa_table(), true);
+    (void)checked;
+#endif
+}
+
+frontend::DFA::~DFA() {}
+
+bool frontend::DFA::next(char input, Token &buf)
+{
+    cur_str += input;
+    TokenView view;
+    bool is_token = next(cur_str.data(), cur_str.size() - 1, view);
+    if (is_token)
+    {
+        buf.type = view.type;
+        buf.value = cur_str.substr(view.offset, view.length);
     }
-    else if (cur_state == State::FloatLiteral)
+    // the characters before cur_begin will never be used
+    cur_str.erase(0, cur_begin);
+    cur_begin = 0;
+    return is_token;
+}
+
+frontend::TokenType frontend::DFA::get_token_type(const char *str, uint32_t len) const
+{
+    switch (dfa_table.state[cur_state])
     {
-        // 状态转移
-        if (is_letter(input))
-        {
-            cur_state = State::FloatLiteral;
-        }
-        else if (is_operator(input))
-        {
-            cur_state = State::op;
-            is_token = true;
-        }
-        else if (is_digit(input))
-        {
-            cur_state = State::FloatLiteral;
-        }
-        else
-        {
-            is_token = true;
-            cur_state = State::Empty;
-        }
+    case State::Ident:
+        return get_keywords_type(str, len);
+    case State::op:
+        return get_op_type(str, len);
+    case State::IntLiteral:
+        return TokenType::INTLTR;
+    case State::FloatLiteral:
+        return TokenType::FLOATLTR;
+    default:
+        assert(0 && "no token in State::Empty");
+    }
+    return TokenType::IDENFR;
+}
 
-        // 更新字符串
-        if (is_token)
-        {
-            buf.value = cur_str;
-            buf.type = TokenType::FLOATLTR;
-            cur_str = "";
-        }
-        if (cur_state != State::Empty)
-            cur_str += input;
+bool frontend::DFA::next(const char *src, uint32_t pos, TokenView &buf)
+{
+    char input = src[pos];
+    const char *cur_str = src + cur_begin; // current token is [cur_str, cur_str + cur_len)
+    uint32_t cur_len = pos - cur_begin;
+#ifdef DEBUG_DFA_BEGIN
+#include <iostream>
+    std::cout << "in state [" << toString(dfa_table.state[cur_state]) << "], input = \'" << input << "\', str = " << std::string(cur_str, cur_len) << "\t";
+#endif
+    // 状态转移, 只需查一次表
+    uint8_t entry = dfa_table.trans[cur_state][dfa_table.cls[(unsigned char)input]];
+    bool is_token = entry & EMIT; // 当前字符串是否为token
+    if (cur_state == R_EMPTY)
+        cur_begin = pos;
+
+    // 输出token, 新的token从input开始
+    if (is_token)
+    {
+        buf.type = get_token_type(cur_str, cur_len);
+        buf.offset = cur_begin;
+        buf.length = cur_len;
+        cur_begin = pos;
     }
+    cur_state = entry & ~EMIT;
+    if (cur_state == R_EMPTY)
+        cur_begin = pos + 1;
 
 #ifdef DEBUG_DFA_END
-    std::cout << ", next state is [" << toString(cur_state) << "], next str = " << cur_str << std::endl;
+    std::cout << ", next state is [" << toString(dfa_table.state[cur_state]) << "], next str = " << std::string(src + cur_begin, pos + 1 - cur_begin) << std::endl;
 #endif
 
     return is_token;
 }
 
+bool frontend::DFA::finish(const char *src, uint32_t end, TokenView &buf)
+{
+    if (cur_state == R_EMPTY)
+        return false;
+    buf.type = get_token_type(src + cur_begin, end - cur_begin);
+    buf.offset = cur_begin;
+    buf.length = end - cur_begin;
+    cur_state = R_EMPTY;
+    cur_begin = end + 1;
+    return true;
+}
+
+frontend::State frontend::DFA::get_state() const
+{
+    return dfa_table.state[cur_state];
+}
+
 void frontend::DFA::reset()
 {
-    cur_state = State::Empty;
+    cur_state = R_EMPTY;
     cur_str = "";
+    cur_begin = 0;
 }
 
-frontend::Scanner::Scanner(std::string filename) : fin(filename)
+frontend::Scanner::Scanner(std::string filename) : fin(filename), filename(filename), source(), dfa(), cursor(0), finished(false), in_comment(false)
 {
     if (!fin.is_open())
     {
@@ -447,4 +639,416 @@ std::vector<frontend::Token> frontend::Scanner::run()
     }
 
     return tk_steam;
+}
+
+frontend::SourceBuffer::SourceBuffer() : buf(nullptr), len(0), mapped(false) {}
+
+frontend::SourceBuffer::~SourceBuffer()
+{
+    close();
+}
+
+bool frontend::SourceBuffer::open(const std::string &filename)
+{
+    close();
+#ifdef _WIN32
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+        return false;
+    len = file.tellg();
+    char *content = new char[len ? len : 1];
+    file.seekg(0);
+    file.read(content, len);
+    buf = content;
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) < 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    len = st.st_size;
+    // mmap can not map an empty file
+    if (len)
+    {
+        void *addr = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED)
+        {
+            ::close(fd);
+            len = 0;
+            return false;
+        }
+        madvise(addr, len, MADV_SEQUENTIAL);
+        buf = static_cast<const char *>(addr);
+        mapped = true;
+    }
+    ::close(fd);
+#endif
+    return true;
+}
+
+void frontend::SourceBuffer::close()
+{
+#ifndef _WIN32
+    if (mapped)
+        munmap(const_cast<char *>(buf), len);
+    else
+#endif
+        delete[] buf;
+    buf = nullptr;
+    len = 0;
+    mapped = false;
+}
+
+const char *frontend::SourceBuffer::data() const
+{
+    return buf;
+}
+
+size_t frontend::SourceBuffer::size() const
+{
+    return len;
+}
+
+#ifdef DEBUG_KEYWORD_BENCH
+#include <chrono>
+#include <iostream>
+
+// the compare chain used before keyword_table, only used as the baseline of the benchmark
+frontend::TokenType compare_chain_keywords_type(const char *str, size_t len)
+{
+    for (const auto &kw : keyword_list)
+        if (len == strlen(kw.word) && memcmp(str, kw.word, len) == 0)
+            return kw.type;
+    return frontend::TokenType::IDENFR;
+}
+
+// microbenchmark: classify every identifier of the input many times, print the cost per identifier
+void bench_keyword_lookup(const char *src, const std::vector<frontend::TokenView> &tk_stream)
+{
+    std::vector<frontend::TokenView> idents;
+    for (const auto &tk : tk_stream)
+        if (dfa_table.cls[(unsigned char)src[tk.offset]] == C_LETTER || dfa_table.cls[(unsigned char)src[tk.offset]] == C_UNDERSCORE)
+            idents.push_back(tk);
+    if (idents.empty())
+        return;
+    const size_t total = 10000000; // lookups of each function
+    size_t rounds = total / idents.size() + 1;
+    auto bench = [&](frontend::TokenType (*lookup)(const char *, size_t))
+    {
+        volatile uint32_t sink = 0;
+        auto begin = std::chrono::steady_clock::now();
+        for (size_t r = 0; r < rounds; r++)
+            for (const auto &tk : idents)
+                sink = sink + (uint32_t)lookup(src + tk.offset, tk.length);
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - begin).count() / (rounds * idents.size());
+    };
+    double chain = bench(compare_chain_keywords_type);
+    double hash = bench(get_keywords_type);
+    std::cout << "keyword lookup: " << idents.size() << " identifiers x " << rounds << " rounds, perfect hash "
+              << hash << " ns/identifier, compare chain " << chain << " ns/identifier" << std::endl;
+}
+#endif
+
+bool frontend::scan_token(const char *src, uint32_t end, uint32_t &i, bool &in_comment, frontend::DFA &dfa, frontend::TokenView &tk)
+{
+    using frontend::State;
+    const frontend::ScanKernels &kernels = frontend::get_scan_kernels();
+    while (i < end)
+    {
+        if (in_comment)
+        {
+            // skip to the char after '*/', the comment may continue after end
+            while ((i = kernels.find_char(src, i, end, '*')) + 1 < end && src[i + 1] != '/')
+                i++;
+            if (i + 1 >= end)
+            {
+                i = end;
+                break;
+            }
+            i += 2;
+            in_comment = false;
+            continue;
+        }
+
+        if (src[i] == '/' && i + 1 < end && (src[i + 1] == '/' || src[i + 1] == '*'))
+        {
+            // a comment ends current token like a space, the comment is skipped in next call
+            if (dfa.finish(src, i, tk))
+                return true;
+            if (src[i + 1] == '/')
+            {
+                // skip to the end of line, '\n' is left to DFA
+                i = kernels.find_char(src, i + 2, end, '\n');
+            }
+            else
+            {
+                i += 2;
+                in_comment = true;
+            }
+            continue;
+        }
+
+        bool is_token = dfa.next(src, i, tk);
+        i++;
+
+        // these characters do not change the state of DFA, and the DFA does not need to see them,
+        // so only the character after them is given to DFA. most runs are short, so the kernels are
+        // called only if the next character can be skipped
+        if (i < end)
+        {
+            uint8_t cls = dfa_table.cls[(unsigned char)src[i]];
+            switch (dfa.get_state())
+            {
+            case State::Empty:
+                if (src[i] == ' ' || src[i] == '\t' || src[i] == '\n' || src[i] == '\r')
+                    i = kernels.skip_space(src, i + 1, end);
+                break;
+            case State::Ident:
+                if (cls == C_LETTER || cls == C_DIGIT || cls == C_UNDERSCORE)
+                    i = kernels.skip_ident(src, i + 1, end);
+                break;
+            case State::IntLiteral:
+            case State::FloatLiteral:
+                if (cls == C_LETTER || cls == C_DIGIT)
+                    i = kernels.skip_alnum(src, i + 1, end);
+                break;
+            default:
+                break;
+            }
+        }
+        if (is_token)
+            return true;
+    }
+    return false;
+}
+
+void frontend::Scanner::open_source()
+{
+    if (!source.data() && !source.open(filename))
+    {
+        assert(0 && "in Scanner, input file cannot open");
+    }
+    assert(source.size() < UINT32_MAX && "in Scanner, input file is too large");
+}
+
+size_t frontend::Scanner::get_source_size()
+{
+    open_source();
+    return source.size();
+}
+
+bool frontend::Scanner::next_token(TokenView &tk)
+{
+    if (finished)
+        return false;
+    open_source();
+    if (scan_token(source.data(), source.size(), cursor, in_comment, dfa, tk))
+        return true;
+    finished = true;
+    return dfa.finish(source.data(), source.size(), tk);
+}
+
+std::vector<frontend::TokenView> frontend::Scanner::run_parallel(uint32_t thread_num)
+{
+    open_source();
+    const char *src = source.data();
+    uint32_t size = source.size();
+    const uint32_t MIN_CHUNK_SIZE = 1 << 16;
+
+    // split the file into chunks, every chunk but the last ends with '\n', so no token crosses two chunks.
+    // there are more chunks than threads, so a thread which finishes early can take another chunk
+    thread_num = thread_num ? thread_num : 1;
+    uint32_t chunk_num = std::max(1u, std::min(thread_num * 4, size / MIN_CHUNK_SIZE));
+    std::vector<uint32_t> bounds = {0};
+    for (uint32_t k = 1; k < chunk_num; k++)
+    {
+        uint32_t pos = get_scan_kernels().find_char(src, std::max(bounds.back(), (uint32_t)((uint64_t)size * k / chunk_num)), size, '\n');
+        if (pos + 1 >= size)
+            break;
+        bounds.push_back(pos + 1);
+    }
+    bounds.push_back(size);
+    chunk_num = bounds.size() - 1;
+
+    struct Chunk
+    {
+        std::vector<TokenView> tokens;
+        bool starts_in_comment; // the comment state which the chunk is scanned with
+        bool ends_in_comment;
+    };
+    std::vector<Chunk> chunks(chunk_num);
+    auto scan_chunk = [&](uint32_t k, bool in_comment)
+    {
+        Chunk &chunk = chunks[k];
+        chunk.tokens.clear();
+        chunk.tokens.reserve((bounds[k + 1] - bounds[k]) / 8);
+        chunk.starts_in_comment = in_comment;
+        DFA chunk_dfa;
+        TokenView tk;
+        uint32_t i = bounds[k];
+        while (scan_token(src, bounds[k + 1], i, in_comment, chunk_dfa, tk))
+            chunk.tokens.push_back(tk);
+        // only the last chunk may have a token here, others end with '\n'
+        if (chunk_dfa.finish(src, bounds[k + 1], tk))
+            chunk.tokens.push_back(tk);
+        chunk.ends_in_comment = in_comment;
+    };
+
+    // every chunk is scanned as if it does not begin inside a block comment
+    std::atomic<uint32_t> next_chunk(0);
+    auto worker = [&]()
+    {
+        for (uint32_t k; (k = next_chunk++) < chunk_num;)
+            scan_chunk(k, false);
+    };
+    std::vector<std::thread> pool;
+    for (uint32_t t = 1; t < std::min(thread_num, chunk_num); t++)
+        pool.emplace_back(worker);
+    worker();
+    for (auto &t : pool)
+        t.join();
+
+    // fix-up: a chunk begins inside a comment if the chunk before it ends inside one, scan it again then
+    bool in_comment = false;
+    size_t token_num = 0;
+    for (uint32_t k = 0; k < chunk_num; k++)
+    {
+        if (chunks[k].starts_in_comment != in_comment)
+            scan_chunk(k, in_comment);
+        in_comment = chunks[k].ends_in_comment;
+        token_num += chunks[k].tokens.size();
+    }
+
+    std::vector<TokenView> tk_stream;
+    tk_stream.reserve(token_num);
+    for (auto &chunk : chunks)
+        tk_stream.insert(tk_stream.end(), chunk.tokens.begin(), chunk.tokens.end());
+    finished = true;
+    return tk_stream;
+}
+
+#ifdef DEBUG_PARALLEL_SCAN
+#include <chrono>
+#include <iostream>
+
+// scaling benchmark: scan the input with 1 to 16 threads, check the result with serial scanning
+void bench_parallel_scan(frontend::Scanner &scanner)
+{
+    const char *src = scanner.get_source().data();
+    uint32_t size = scanner.get_source().size();
+    std::vector<frontend::TokenView> serial;
+    frontend::DFA dfa;
+    frontend::TokenView tk;
+    bool in_comment = false;
+    uint32_t i = 0;
+    auto begin = std::chrono::steady_clock::now();
+    while (frontend::scan_token(src, size, i, in_comment, dfa, tk))
+        serial.push_back(tk);
+    if (dfa.finish(src, size, tk))
+        serial.push_back(tk);
+    auto end = std::chrono::steady_clock::now();
+    double base = std::chrono::duration<double, std::milli>(end - begin).count();
+    std::cout << "parallel scan: " << size << " bytes, " << serial.size() << " tokens, serial " << base << " ms" << std::endl;
+    for (uint32_t thread_num = 1; thread_num <= 16; thread_num *= 2)
+    {
+        begin = std::chrono::steady_clock::now();
+        auto result = scanner.run_parallel(thread_num);
+        end = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(end - begin).count();
+        assert(result.size() == serial.size() && "in bench_parallel_scan, token number differs from serial result");
+        for (size_t k = 0; k < serial.size(); k++)
+            assert(result[k].type == serial[k].type && result[k].offset == serial[k].offset && result[k].length == serial[k].length &&
+                   "in bench_parallel_scan, token differs from serial result");
+        std::cout << "parallel scan: " << thread_num << " threads " << ms << " ms, speedup " << base / ms << std::endl;
+    }
+}
+#endif
+
+std::vector<frontend::TokenView> frontend::Scanner::run_mapped()
+{
+    open_source();
+    std::vector<frontend::TokenView> tk_stream;
+    // threads are not worth starting for small files
+    const uint32_t PARALLEL_SCAN_MIN_SIZE = 1 << 22;
+    uint32_t thread_num = std::thread::hardware_concurrency();
+    if (cursor == 0 && source.size() >= PARALLEL_SCAN_MIN_SIZE && thread_num > 1)
+    {
+        tk_stream = run_parallel(thread_num);
+    }
+    else
+    {
+        frontend::TokenView tk;
+        tk_stream.reserve(source.size() / 8);
+        while (next_token(tk))
+            tk_stream.push_back(tk);
+    }
+#ifdef DEBUG_SCANNER
+#include <iostream>
+    for (const auto &tk : tk_stream)
+        std::cout << "token: " << toString(tk.type) << "\t" << get_text(tk) << std::endl;
+#endif
+
+#ifdef DEBUG_KEYWORD_BENCH
+    bench_keyword_lookup(source.data(), tk_stream);
+#endif
+#ifdef DEBUG_PARALLEL_SCAN
+    bench_parallel_scan(*this);
+#endif
+    return tk_stream;
+}
+
+const frontend::SourceBuffer &frontend::Scanner::get_source() const
+{
+    return source;
+}
+
+std::string frontend::Scanner::get_text(const TokenView &tk) const
+{
+    return std::string(source.data() + tk.offset, tk.length);
+}
+
+frontend::TokenStream::TokenStream(Scanner &scanner) : scanner(&scanner), tokens(nullptr), vector_index(0), window(), head(0), count(0) {}
+
+frontend::TokenStream::TokenStream(const std::vector<Token> &tokens) : scanner(nullptr), tokens(&tokens), vector_index(0), window(), head(0), count(0) {}
+
+void frontend::TokenStream::fill()
+{
+    Token &tk = window[(head + count) & (LOOKAHEAD - 1)];
+    TokenView view;
+    if (scanner && scanner->next_token(view))
+    {
+        tk.type = view.type;
+        tk.value = ir::Symbol(scanner->get_source().data() + view.offset, view.length);
+    }
+    else if (tokens && vector_index < tokens->size())
+    {
+        tk = (*tokens)[vector_index++];
+    }
+    else
+    {
+        tk.type = TokenType::ENDTK;
+        tk.value = ir::Symbol();
+    }
+    count++;
+}
+
+const frontend::Token &frontend::TokenStream::peek(uint32_t k)
+{
+    assert(k < LOOKAHEAD && "in TokenStream::peek, look ahead too far");
+    while (count <= k)
+        fill();
+    return window[(head + k) & (LOOKAHEAD - 1)];
+}
+
+void frontend::TokenStream::advance()
+{
+    if (count == 0)
+        fill();
+    head = (head + 1) & (LOOKAHEAD - 1);
+    count--;
 }
\ No newline at end of file
@@ -0,0 +1,190 @@
+#include "front/lexical_simd.h"
+
+// #define DEBUG_SCAN_SCALAR
+
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(DEBUG_SCAN_SCALAR)
+#define SCAN_SIMD
+#include <immintrin.h>
+#endif
+
+bool is_space_char(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool is_alnum_char(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+}
+
+uint32_t scalar_skip_space(const char *src, uint32_t pos, uint32_t end)
+{
+    while (pos < end && is_space_char(src[pos]))
+        pos++;
+    return pos;
+}
+
+uint32_t scalar_skip_ident(const char *src, uint32_t pos, uint32_t end)
+{
+    while (pos < end && (is_alnum_char(src[pos]) || src[pos] == '_'))
+        pos++;
+    return pos;
+}
+
+uint32_t scalar_skip_alnum(const char *src, uint32_t pos, uint32_t end)
+{
+    while (pos < end && is_alnum_char(src[pos]))
+        pos++;
+    return pos;
+}
+
+uint32_t scalar_find_char(const char *src, uint32_t pos, uint32_t end, char c)
+{
+    while (pos < end && src[pos] != c)
+        pos++;
+    return pos;
+}
+
+#ifdef SCAN_SIMD
+
+// the characters are compared as signed bytes, so non-ASCII bytes are negative and never in a range
+#define SSE2_IN_RANGE(v, lo, hi) _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8((lo)-1)), _mm_cmplt_epi8(v, _mm_set1_epi8((hi) + 1)))
+#define AVX2_IN_RANGE(v, lo, hi) _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8((lo)-1)), _mm256_cmpgt_epi8(_mm256_set1_epi8((hi) + 1), v))
+
+// a bit is set for every byte in [src + pos, src + pos + 16) which is matched
+inline __m128i sse2_space_mask(__m128i v)
+{
+    return _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+                        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+}
+
+inline __m128i sse2_alnum_mask(__m128i v)
+{
+    // 'A'-'Z' | 0x20 is 'a'-'z', and digits are not changed by | 0x20
+    __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    return _mm_or_si128(SSE2_IN_RANGE(lower, 'a', 'z'), SSE2_IN_RANGE(v, '0', '9'));
+}
+
+inline __m128i sse2_ident_mask(__m128i v)
+{
+    return _mm_or_si128(sse2_alnum_mask(v), _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+}
+
+// SSE2 is always supported on x86-64, the loop stops at the first byte whose bit is 0 in the mask
+#define SSE2_SKIP(src, pos, end, MASK)                                                     \
+    while (pos + 16 <= end)                                                                \
+    {                                                                                      \
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + pos));         \
+        uint32_t miss = ~(uint32_t)_mm_movemask_epi8(MASK) & 0xffff;                       \
+        if (miss)                                                                          \
+            return pos + __builtin_ctz(miss);                                              \
+        pos += 16;                                                                         \
+    }
+
+uint32_t sse2_skip_space(const char *src, uint32_t pos, uint32_t end)
+{
+    SSE2_SKIP(src, pos, end, sse2_space_mask(v));
+    return scalar_skip_space(src, pos, end);
+}
+
+uint32_t sse2_skip_ident(const char *src, uint32_t pos, uint32_t end)
+{
+    SSE2_SKIP(src, pos, end, sse2_ident_mask(v));
+    return scalar_skip_ident(src, pos, end);
+}
+
+uint32_t sse2_skip_alnum(const char *src, uint32_t pos, uint32_t end)
+{
+    SSE2_SKIP(src, pos, end, sse2_alnum_mask(v));
+    return scalar_skip_alnum(src, pos, end);
+}
+
+uint32_t sse2_find_char(const char *src, uint32_t pos, uint32_t end, char c)
+{
+    __m128i target = _mm_set1_epi8(c);
+    while (pos + 16 <= end)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + pos));
+        uint32_t hit = _mm_movemask_epi8(_mm_cmpeq_epi8(v, target));
+        if (hit)
+            return pos + __builtin_ctz(hit);
+        pos += 16;
+    }
+    return scalar_find_char(src, pos, end, c);
+}
+
+__attribute__((target("avx2"))) inline __m256i avx2_space_mask(__m256i v)
+{
+    return _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+                           _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+}
+
+__attribute__((target("avx2"))) inline __m256i avx2_alnum_mask(__m256i v)
+{
+    __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+    return _mm256_or_si256(AVX2_IN_RANGE(lower, 'a', 'z'), AVX2_IN_RANGE(v, '0', '9'));
+}
+
+__attribute__((target("avx2"))) inline __m256i avx2_ident_mask(__m256i v)
+{
+    return _mm256_or_si256(avx2_alnum_mask(v), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')));
+}
+
+// the same as SSE2_SKIP, but 32 bytes at a time, the tail is left to SSE2
+#define AVX2_SKIP(src, pos, end, MASK)                                                     \
+    while (pos + 32 <= end)                                                                \
+    {                                                                                      \
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + pos));      \
+        uint32_t miss = ~(uint32_t)_mm256_movemask_epi8(MASK);                             \
+        if (miss)                                                                          \
+            return pos + __builtin_ctz(miss);                                              \
+        pos += 32;                                                                         \
+    }
+
+__attribute__((target("avx2"))) uint32_t avx2_skip_space(const char *src, uint32_t pos, uint32_t end)
+{
+    AVX2_SKIP(src, pos, end, avx2_space_mask(v));
+    return sse2_skip_space(src, pos, end);
+}
+
+__attribute__((target("avx2"))) uint32_t avx2_skip_ident(const char *src, uint32_t pos, uint32_t end)
+{
+    AVX2_SKIP(src, pos, end, avx2_ident_mask(v));
+    return sse2_skip_ident(src, pos, end);
+}
+
+__attribute__((target("avx2"))) uint32_t avx2_skip_alnum(const char *src, uint32_t pos, uint32_t end)
+{
+    AVX2_SKIP(src, pos, end, avx2_alnum_mask(v));
+    return sse2_skip_alnum(src, pos, end);
+}
+
+__attribute__((target("avx2"))) uint32_t avx2_find_char(const char *src, uint32_t pos, uint32_t end, char c)
+{
+    __m256i target = _mm256_set1_epi8(c);
+    while (pos + 32 <= end)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + pos));
+        uint32_t hit = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, target));
+        if (hit)
+            return pos + __builtin_ctz(hit);
+        pos += 32;
+    }
+    return sse2_find_char(src, pos, end, c);
+}
+
+#endif
+
+const frontend::ScanKernels &frontend::get_scan_kernels()
+{
+    static const ScanKernels scalar = {"scalar", scalar_skip_space, scalar_skip_ident, scalar_skip_alnum, scalar_find_char};
+#ifdef SCAN_SIMD
+    static const ScanKernels sse2 = {"sse2", sse2_skip_space, sse2_skip_ident, sse2_skip_alnum, sse2_find_char};
+    static const ScanKernels avx2 = {"avx2", avx2_skip_space, avx2_skip_ident, avx2_skip_alnum, avx2_find_char};
+    static const ScanKernels *kernels = __builtin_cpu_supports("avx2") ? &avx2 : __builtin_cpu_supports("sse2") ? &sse2
+                                                                                                               : &scalar;
+    return *kernels;
+#else
+    return scalar;
+#endif
+}
@@ -4,6 +4,10 @@
 #include <numeric>
 #include <iostream>
 #include <cmath>
+#include <algorithm>
+
+// #define DEBUG_STRESS_CHAIN
+// #define DEBUG_SYMBOL_TABLE
 
 using ir::Function;
 using ir::Instruction;
@@ -12,30 +16,39 @@ using ir::Operator;
 
 #define TODO assert(0 && "TODO");
 
-// 获取一个树节点的指定类型子节点的指针，若获取失败，使用 assert 断言来停止程序的执行
-#define GET_CHILD_PTR(node, node_type, index)                     \
-    auto node = dynamic_cast<node_type *>(root->children[index]); \
-    assert(node);
-
-// 获取一个树节点的指定类型子节点的指针，并调用一个名为 analysis<type> 的函数来对这个子节点进行分析
-#define ANALYSIS(node, type, index)                          \
-    auto node = dynamic_cast<type *>(root->children[index]); \
-    assert(node);                                            \
+#ifdef DEBUG_STRESS_CHAIN
+void stress_chain();
+#endif
+#ifdef DEBUG_SYMBOL_TABLE
+void bench_symbol_table();
+#endif
+
+// 获取一个树节点的指定类型子节点，若类型不符，使用 assert 断言来停止程序的执行
+#define GET_CHILD_PTR(node, node_type, index)                  \
+    assert((index) < root->children.size());                   \
+    auto node = ast->get_node(root->children[index]);              \
+    assert(node->type == flat_node_type<node_type>::value);
+
+// 获取一个树节点的指定类型子节点，并调用一个名为 analysis<type> 的函数来对这个子节点进行分析
+#define ANALYSIS(node, type, index)                       \
+    auto node = ast->get_node(root->children[index]);         \
+    assert(node->type == flat_node_type<type>::value);    \
     analysis##type(node, buffer);
 
 // 将一个表达式节点的信息复制到另一个表达式节点中
 #define COPY_EXP_NODE(from, to)              \
     to->is_computable = from->is_computable; \
     to->v = from->v;                         \
-    to->t = from->t;
+    to->t = from->t;                         \
+    to->c = from->c;
 
 // 判断节点是否为指定类型
-#define NODE_IS(node_type, index) root->children[index]->type == NodeType::node_type
+#define NODE_IS(node_type, index) ast->type_of(root->children[index]) == NodeType::node_type
 
 // 获取库函数
-map<std::string, Function *> *frontend::get_lib_funcs()
+std::unordered_map<ir::Symbol, Function *> *frontend::get_lib_funcs()
 {
-    static map<std::string, Function *> lib_funcs = {
+    static std::unordered_map<ir::Symbol, Function *> lib_funcs = {
         {"getint", new Function("getint", Type::Int)},
         {"getch", new Function("getch", Type::Int)},
         {"getfloat", new Function("getfloat", Type::Float)},
@@ -50,34 +63,71 @@ map<std::string, Function *> *frontend::get_lib_funcs()
     return &lib_funcs;
 }
 
+const uint32_t frontend::SymbolTable::NONE;
+
 void frontend::SymbolTable::add_scope()
 {
-    scope_stack.push_back(ScopeInfo());
+    scope_begin.push_back(bindings.size());
 }
 
 void frontend::SymbolTable::exit_scope()
 {
-    scope_stack.pop_back();
+    assert(!scope_begin.empty() && "in SymbolTable::exit_scope, no scope");
+    // 从后向前撤销, 每个名字恢复为被遮住的声明
+    while (bindings.size() > scope_begin.back())
+    {
+        const SymbolBinding &b = bindings.back();
+        if (b.shadowed == NONE)
+            table.erase(b.id);
+        else
+            table[b.id] = b.shadowed;
+        bindings.pop_back();
+    }
+    scope_begin.pop_back();
 }
 
-string frontend::SymbolTable::get_scoped_name(string id) const
+ir::Symbol frontend::SymbolTable::get_scoped_name(ir::Symbol id) const
 {
-    return id + "_" + std::to_string(scope_stack.size());
+    // 同一个名字在同一层的重命名结果相同, 只生成一次字符串
+    uint64_t key = (uint64_t)id.id() << 32 | scope_begin.size();
+    auto iter = scoped_names.find(key);
+    if (iter != scoped_names.end())
+        return iter->second;
+    ir::Symbol name = id + "_" + std::to_string(scope_begin.size());
+    scoped_names.insert({key, name});
+    return name;
 }
 
-Operand frontend::SymbolTable::get_operand(string id) const
+Operand frontend::SymbolTable::get_operand(ir::Symbol id) const
 {
     return get_ste(id).operand;
 }
 
-void frontend::SymbolTable::add_operand(std::string name, STE ste)
+void frontend::SymbolTable::add_operand(ir::Symbol name, STE ste)
 {
-    scope_stack.back().table[name] = ste;
+    assert(!scope_begin.empty() && "in SymbolTable::add_operand, no scope");
+    uint32_t depth = scope_begin.size();
+    auto iter = table.find(name);
+    if (iter != table.end() && bindings[iter->second].depth == depth)
+    {
+        bindings[iter->second].ste = ste;
+        return;
+    }
+    uint32_t shadowed = iter == table.end() ? NONE : iter->second;
+    table[name] = bindings.size();
+    bindings.push_back({name, ste, shadowed, depth});
 }
 
-std::string frontend::Analyzer::get_temp_name()
+std::pair<uint32_t, uint32_t> frontend::SymbolTable::current_scope() const
 {
-    return "temp_" + std::to_string(tmp_cnt++);
+    assert(!scope_begin.empty() && "in SymbolTable::current_scope, no scope");
+    return {scope_begin.back(), (uint32_t)bindings.size()};
+}
+
+// 临时变量是虚拟寄存器, 只有一个编号, 输出时才生成名字 "temp_n"
+ir::Symbol frontend::Analyzer::get_temp_name()
+{
+    return ir::Symbol::vreg(tmp_cnt++);
 }
 
 void frontend::Analyzer::delete_temp_name()
@@ -86,61 +136,114 @@ void frontend::Analyzer::delete_temp_name()
     return;
 }
 
-frontend::STE frontend::SymbolTable::get_ste(string id) const
+frontend::STE frontend::SymbolTable::get_ste(ir::Symbol id) const
 {
-    for (auto i = scope_stack.rbegin(); i != scope_stack.rend(); i++)
-    {
-        if (i->table.find(id) != i->table.end())
-        {
-            return i->table.at(id);
-        }
-    }
+    auto iter = table.find(id);
+    assert(iter != table.end() && "in SymbolTable::get_ste, undeclared identifier");
+    return bindings[iter->second].ste;
 }
 
-frontend::Analyzer::Analyzer() : tmp_cnt(0), symbol_table()
+frontend::Analyzer::Analyzer() : tmp_cnt(0), symbol_table(), ast(nullptr)
 {
     symbol_table.add_scope();
 }
 
 ir::Program frontend::Analyzer::get_ir_program(CompUnit *root)
 {
+    FlatAst flat(root);
+    return get_ir_program(flat);
+}
 
-    ir::Program program;
+ir::Program frontend::Analyzer::get_ir_program(FlatAst &flat)
+{
 
-    analysisCompUnit(root);
+    ir::Program program;
 
-    // 添加全局变量
-    for (auto &p : symbol_table.scope_stack.back().table) // 遍历最外层作用域的符号表
+#ifdef DEBUG_STRESS_CHAIN
+    static bool stressed = false;
+    if (!stressed)
+    {
+        stressed = true;
+        stress_chain();
+    }
+#endif
+#ifdef DEBUG_SYMBOL_TABLE
+    static bool benched = false;
+    if (!benched)
+    {
+        benched = true;
+        bench_symbol_table();
+    }
+#endif
+
+    ast = &flat;
+    analysisCompUnit(ast->get_node(0));
+
+    // 添加全局变量, 符号表是哈希表, 按名字排序以保证输出顺序不变
+    std::vector<SymbolBinding *> globals;
+    auto scope = symbol_table.current_scope(); // 最外层作用域的声明
+    for (uint32_t i = scope.first; i < scope.second; i++)
+        globals.push_back(&symbol_table.bindings[i]);
+    std::sort(globals.begin(), globals.end(), [](const SymbolBinding *a, const SymbolBinding *b)
+              { return a->id.str() < b->id.str(); });
+    for (auto p : globals)
     {
-        if (p.second.dimension.size()) // 如果是数组
+        if (p->ste.dimension.size()) // 如果是数组
         {
             // 计算数组大小
-            int size = std::accumulate(p.second.dimension.begin(), p.second.dimension.end(), 1, std::multiplies<int>());
+            int size = std::accumulate(p->ste.dimension.begin(), p->ste.dimension.end(), 1, std::multiplies<int>());
             // 添加数组
-            program.globalVal.push_back({p.second.operand, size});
-            continue;
+            program.globalVal.push_back({p->ste.operand, size});
+        }
+        else if (p->ste.operand.type == ir::Type::FloatLiteral || p->ste.operand.type == ir::Type::IntLiteral)
+        {
+            // 添加常量, 它的值就是初始值
+            program.globalVal.push_back({Operand(p->id, p->ste.operand.type)});
+            program.globalVal.back().init = {p->ste.value.bits()};
+        }
+        else
+        {
+            // 添加变量
+            program.globalVal.push_back({p->ste.operand});
         }
-        if (p.second.operand.type == ir::Type::FloatLiteral || p.second.operand.type == ir::Type::IntLiteral)
-            p.second.operand.name = p.first;
-        // 添加变量
-        program.globalVal.push_back({p.second.operand});
-    }
 
-    // 把全局变量的初始化指令添加到 _global 函数中
-    Function g("_global", ir::Type::null);
-    for (auto &i : g_init_inst) // 遍历全局变量的初始化指令
+        auto &gv = program.globalVal.back();
+        auto iter = g_init_val.find(gv.val.name);
+        if (iter != g_init_val.end())
+            gv.init = std::move(iter->second);
+        while (gv.init.size() && gv.init.back() == 0)
+            gv.init.pop_back();
+    }
+    g_init_val.clear();
+    // 局部数组的常量块放在全局变量之后
+    for (auto &block : const_blocks)
+        program.globalVal.push_back(std::move(block));
+    const_blocks.clear();
+
+    // 把全局变量的初始化指令添加到 _global 函数中, 全部是静态初始化时没有 _global 函数
+    ir::CallInst *call_global = nullptr;
+    if (g_init_inst.size())
     {
-        g.addInst(i);
+        Function g("_global", ir::Type::null);
+        for (auto &i : g_init_inst) // 遍历全局变量的初始化指令
+        {
+            g.addInst(i);
+        }
+        g.addInst(new Instruction({}, {}, {}, Operator::_return));
+        program.addFunction(g);
+        call_global = new ir::CallInst(Operand("_global", ir::Type::null), Operand());
     }
-    g.addInst(new Instruction({}, {}, {}, Operator::_return));
-    program.addFunction(g);
 
-    auto call_global = new ir::CallInst(Operand("_global", ir::Type::null), Operand());
-
-    // 把函数添加到 ir::Program 中
+    // 把函数添加到 ir::Program 中, 同样按名字排序
+    std::vector<std::pair<const ir::Symbol, Function *> *> funcs;
     for (auto &f : symbol_table.functions)
+        funcs.push_back(&f);
+    std::sort(funcs.begin(), funcs.end(), [](const std::pair<const ir::Symbol, Function *> *a, const std::pair<const ir::Symbol, Function *> *b)
+              { return a->first.str() < b->first.str(); });
+    for (auto pf : funcs)
     {
-        if (f.first == "main") // 如果是main函数
+        auto &f = *pf;
+        if (f.first == "main" && call_global) // 如果是main函数
         {
             // 在main函数前面添加一个调用 _global 函数的指令
             f.second->InstVec.insert(f.second->InstVec.begin(), call_global);
@@ -150,33 +253,186 @@ ir::Program frontend::Analyzer::get_ir_program(CompUnit *root)
     return program;
 }
 
-// CompUnit -> (Decl | FuncDef) [CompUnit]
-void frontend::Analyzer::analysisCompUnit(CompUnit *root)
+// 字面量操作数, 没有化简的常量表达式的值是临时变量, 但类型也可能是 Literal
+bool is_literal_operand(const Operand &op)
 {
-    if (NODE_IS(DECL, 0)) // 如果是声明
+    return frontend::ConstValue::is_literal(op.type) && !op.name.is_vreg();
+}
+
+// 全局声明的初始化指令只有以下几种时, 初始值都是常量:
+// def/fdef/mov/fmov 字面量到变量, alloc 数组, store 字面量到数组的字面量下标
+void frontend::Analyzer::fold_global_init(size_t begin)
+{
+    for (size_t i = begin; i < g_init_inst.size(); i++)
     {
-        GET_CHILD_PTR(decl, Decl, 0);
-        // 生成全局变量的初始化指令
-        analysisDecl(decl, g_init_inst);
+        Instruction *inst = g_init_inst[i];
+        switch (inst->op)
+        {
+        case Operator::def:
+        case Operator::fdef:
+        case Operator::mov:
+        case Operator::fmov:
+        case Operator::alloc:
+            if (!is_literal_operand(inst->op1))
+                return;
+            break;
+        case Operator::store:
+        case Operator::fill:
+            if (!is_literal_operand(inst->des) || !is_literal_operand(inst->op2))
+                return;
+            break;
+        default:
+            return;
+        }
     }
-    else // 如果是函数定义
+
+    for (size_t i = begin; i < g_init_inst.size(); i++)
     {
-        GET_CHILD_PTR(funcdef, FuncDef, 0);
-        symbol_table.add_scope();
-        // 生成一个新的函数
-        analysisFuncDef(funcdef);
-        symbol_table.exit_scope();
+        Instruction *inst = g_init_inst[i];
+        switch (inst->op)
+        {
+        case Operator::def:
+        case Operator::mov:
+        case Operator::fdef:
+        case Operator::fmov:
+            // 临时变量只在这些指令中被赋值, 没有被使用
+            if (!inst->des.name.is_vreg())
+            {
+                ir::Type type = (inst->op == Operator::def || inst->op == Operator::mov) ? ir::Type::IntLiteral : ir::Type::FloatLiteral;
+                g_init_val[inst->des.name] = {ConstValue::of_operand(inst->op1).cast(type).bits()};
+            }
+            break;
+        case Operator::alloc:
+            g_init_val[inst->des.name].clear();
+            break;
+        case Operator::store:
+        {
+            ir::Type type = inst->op1.type == ir::Type::FloatPtr ? ir::Type::FloatLiteral : ir::Type::IntLiteral;
+            int index = ConstValue::of_operand(inst->op2).to_int();
+            assert(index >= 0 && "in fold_global_init, negative index");
+            auto &words = g_init_val[inst->op1.name];
+            if (words.size() <= (size_t)index)
+                words.resize(index + 1, 0);
+            words[index] = ConstValue::of_operand(inst->des).cast(type).bits();
+            break;
+        }
+        case Operator::fill:
+        {
+            // 数组的字默认为 0, 只需清除已经写入的值
+            auto &words = g_init_val[inst->op1.name];
+            size_t first = ConstValue::of_operand(inst->op2).to_int();
+            size_t last = std::min(words.size(), first + ConstValue::of_operand(inst->des).to_int());
+            for (size_t k = first; k < last; k++)
+                words[k] = 0;
+            break;
+        }
+        default:
+            break;
+        }
+        delete inst;
+    }
+    g_init_inst.resize(begin);
+}
+
+void frontend::Analyzer::init_array(Operand arr, int size, size_t begin, vector<Instruction *> &instructions)
+{
+    // 全局数组的 store 由 fold_global_init 处理
+    bool is_literal = &instructions != &g_init_inst;
+    for (size_t i = begin; is_literal && i < instructions.size(); i++)
+    {
+        Instruction *inst = instructions[i];
+        if (inst->op == Operator::store)
+            is_literal = inst->op1.name == arr.name && is_literal_operand(inst->des) && is_literal_operand(inst->op2);
+        else // ConstInitVal 把非 0 的值先 mov 到临时变量
+            is_literal = (inst->op == Operator::mov || inst->op == Operator::fmov) && inst->des.name.is_vreg() && is_literal_operand(inst->op1);
+    }
+    if (!is_literal)
+    {
+        // fill:置 0，op1:数组名，op2:开始的下标，des:元素个数
+        instructions.insert(instructions.begin() + begin, new Instruction(arr,
+                                                                          {ir::Symbol::int_literal(0), ir::Type::IntLiteral},
+                                                                          {ir::Symbol::int_literal(size), ir::Type::IntLiteral},
+                                                                          Operator::fill));
+        return;
+    }
+
+    ir::Type type = arr.type == ir::Type::FloatPtr ? ir::Type::FloatLiteral : ir::Type::IntLiteral;
+    vector<uint32_t> words;
+    for (size_t i = begin; i < instructions.size(); i++)
+    {
+        Instruction *inst = instructions[i];
+        if (inst->op == Operator::store)
+        {
+            int index = ConstValue::of_operand(inst->op2).to_int();
+            assert(index >= 0 && index < size && "in init_array, index out of range");
+            if (words.size() <= (size_t)index)
+                words.resize(index + 1, 0);
+            words[index] = ConstValue::of_operand(inst->des).cast(type).bits();
+        }
+        delete inst;
     }
+    instructions.resize(begin);
+    while (words.size() && words.back() == 0)
+        words.pop_back();
 
-    if (root->children.size() == 2)
+    int n = words.size();
+    if (n)
     {
-        GET_CHILD_PTR(compunit, CompUnit, 1);
-        analysisCompUnit(compunit);
+        // 常量块的名字含有 '.', 不会与源程序中的名字相同
+        ir::GlobalVal block(Operand(arr.name + ".init" + std::to_string(const_blocks.size()), arr.type), n);
+        block.init = std::move(words);
+        // copy:复制，op1:数组名，op2:常量块，des:元素个数
+        instructions.push_back(new Instruction(arr,
+                                               block.val,
+                                               {ir::Symbol::int_literal(n), ir::Type::IntLiteral},
+                                               Operator::copy));
+        const_blocks.push_back(std::move(block));
+    }
+    if (n < size)
+    {
+        // fill:置 0，op1:数组名，op2:开始的下标，des:元素个数
+        instructions.push_back(new Instruction(arr,
+                                               {ir::Symbol::int_literal(n), ir::Type::IntLiteral},
+                                               {ir::Symbol::int_literal(size - n), ir::Type::IntLiteral},
+                                               Operator::fill));
+    }
+}
+
+// CompUnit -> (Decl | FuncDef) [CompUnit]
+// CompUnit 链用循环代替递归, 全局声明很多时也不会栈溢出
+void frontend::Analyzer::analysisCompUnit(FlatNode unit)
+{
+    for (NodeId id = unit->id; id != FlatAst::NONE;)
+    {
+        FlatNode root = ast->get_node(id);
+        if (NODE_IS(DECL, 0)) // 如果是声明
+        {
+            GET_CHILD_PTR(decl, Decl, 0);
+            // 生成全局变量的初始化指令, 初始值都是常量时改为静态初始化
+            size_t begin = g_init_inst.size();
+            analysisDecl(decl, g_init_inst);
+            fold_global_init(begin);
+        }
+        else // 如果是函数定义
+        {
+            GET_CHILD_PTR(funcdef, FuncDef, 0);
+            symbol_table.add_scope();
+            // 生成一个新的函数
+            analysisFuncDef(funcdef);
+            symbol_table.exit_scope();
+        }
+
+        id = FlatAst::NONE;
+        if (root->children.size() == 2)
+        {
+            GET_CHILD_PTR(compunit, CompUnit, 1);
+            id = compunit->id;
+        }
     }
 }
 
 // Decl -> ConstDecl | VarDecl
-void frontend::Analyzer::analysisDecl(Decl *root, vector<Instruction *> &instructions)
+void frontend::Analyzer::analysisDecl(FlatNode root, vector<Instruction *> &instructions)
 {
     if (NODE_IS(VARDECL, 0)) // 如果是变量声明
     {
@@ -194,7 +450,7 @@ void frontend::Analyzer::analysisDecl(Decl *root, vector<Instruction *> &instruc
 
 // ConstDecl -> 'const' BType ConstDef { ',' ConstDef } ';'
 // ConstDecl.t
-void frontend::Analyzer::analysisConstDecl(ConstDecl *root, vector<Instruction *> &instructions)
+void frontend::Analyzer::analysisConstDecl(FlatNode root, vector<Instruction *> &instructions)
 {
     GET_CHILD_PTR(btype, BType, 1);
     analysisBType(btype);
@@ -212,7 +468,7 @@ void frontend::Analyzer::analysisConstDecl(ConstDecl *root, vector<Instruction *
 
 // ConstDef -> Ident { '[' ConstExp ']' } '=' ConstInitVal
 // ConstDef.arr_name
-void frontend::Analyzer::analysisConstDef(ConstDef *root, vector<Instruction *> &instructions, ir::Type type)
+void frontend::Analyzer::analysisConstDef(FlatNode root, vector<Instruction *> &instructions, ir::Type type)
 {
     GET_CHILD_PTR(ident, Term, 0);
     root->arr_name = symbol_table.get_scoped_name(ident->token.value);
@@ -227,7 +483,8 @@ void frontend::Analyzer::analysisConstDef(ConstDef *root, vector<Instruction *>
         constexp->v = root->arr_name;
         constexp->t = type;
         analysisConstExp(constexp, instructions);
-        dimension.push_back(std::stoi(constexp->v));
+        assert(ConstValue::is_literal(constexp->t) && "array dimension is not a constant");
+        dimension.push_back(constexp->c.to_int());
     }
 
     int size = std::accumulate(dimension.begin(), dimension.end(), 1, std::multiplies<int>());
@@ -263,7 +520,7 @@ void frontend::Analyzer::analysisConstDef(ConstDef *root, vector<Instruction *>
         {
         case ir::Type::Int:
             // alloc:内存分配，op1:数组长度，op2:不使用，des:数组名，数组名被视为一个指针
-            instructions.push_back(new Instruction({std::to_string(size), ir::Type::IntLiteral},
+            instructions.push_back(new Instruction({ir::Symbol::int_literal(size), ir::Type::IntLiteral},
                                                    {},
                                                    {root->arr_name, ir::Type::IntPtr},
                                                    Operator::alloc));
@@ -271,7 +528,7 @@ void frontend::Analyzer::analysisConstDef(ConstDef *root, vector<Instruction *>
             break;
         case ir::Type::Float:
             // alloc:内存分配，op1:数组长度，op2:不使用，des:数组名，数组名被视为一个指针
-            instructions.push_back(new Instruction({std::to_string(size), ir::Type::IntLiteral},
+            instructions.push_back(new Instruction({ir::Symbol::int_literal(size), ir::Type::IntLiteral},
                                                    {},
                                                    {root->arr_name, ir::Type::FloatPtr},
                                                    Operator::alloc));
@@ -285,18 +542,22 @@ void frontend::Analyzer::analysisConstDef(ConstDef *root, vector<Instruction *>
     GET_CHILD_PTR(constinitval, ConstInitVal, root->children.size() - 1);
     constinitval->v = root->arr_name;
     constinitval->t = type;
+    size_t begin = instructions.size();
     analysisConstInitVal(constinitval, instructions);
+    if (dimension.size())
+        init_array({root->arr_name, res_type}, size, begin, instructions);
 
     // 如果是常量，constinitval->v是一个立即数，Type应该为Literal; 如果是数组，constinitval->v是数组名，Type应该为Ptr
     symbol_table.add_operand(ident->token.value,
                              {Operand(constinitval->v, res_type),
-                              dimension});
+                              dimension,
+                              constinitval->c});
 }
 
 // ConstInitVal -> ConstExp | '{' [ ConstInitVal { ',' ConstInitVal } ] '}'
 // ConstInitVal.v
 // ConstInitVal.t
-void frontend::Analyzer::analysisConstInitVal(ConstInitVal *root, vector<Instruction *> &instructions)
+void frontend::Analyzer::analysisConstInitVal(FlatNode root, vector<Instruction *> &instructions)
 {
     if (NODE_IS(CONSTEXP, 0))
     {
@@ -304,7 +565,7 @@ void frontend::Analyzer::analysisConstInitVal(ConstInitVal *root, vector<Instruc
         constexp->v = get_temp_name();
         constexp->t = root->t; // Int or Float
         analysisConstExp(constexp, instructions);
-        if (!(constexp->v == "0" || constexp->v == "0.0"))
+        if (!(ConstValue::is_literal(constexp->t) && constexp->c.is_zero()))
         {
             switch (root->t)
             {
@@ -312,7 +573,8 @@ void frontend::Analyzer::analysisConstInitVal(ConstInitVal *root, vector<Instruc
                 if (constexp->t == ir::Type::FloatLiteral)
                 {
                     constexp->t = ir::Type::IntLiteral;
-                    constexp->v = std::to_string((int)std::stof(constexp->v));
+                    constexp->c = constexp->c.cast(ir::Type::IntLiteral);
+                    constexp->v = constexp->c.to_symbol();
                 }
                 // mov:赋值，op1:立即数或变量，op2:不使用，des:被赋值变量
                 instructions.push_back(new Instruction({constexp->v, ir::Type::IntLiteral},
@@ -324,7 +586,8 @@ void frontend::Analyzer::analysisConstInitVal(ConstInitVal *root, vector<Instruc
                 if (constexp->t == ir::Type::IntLiteral)
                 {
                     constexp->t = ir::Type::FloatLiteral;
-                    constexp->v = std::to_string((float)std::stoi(constexp->v));
+                    constexp->c = constexp->c.cast(ir::Type::FloatLiteral);
+                    constexp->v = constexp->c.to_symbol();
                 }
                 // fmov:浮点数赋值，op1:立即数或变量，op2:不使用，des:被赋值变量
                 instructions.push_back(new Instruction({constexp->v, ir::Type::FloatLiteral},
@@ -336,6 +599,9 @@ void frontend::Analyzer::analysisConstInitVal(ConstInitVal *root, vector<Instruc
                 break;
             }
         }
+        // 常量的值总是声明的类型, 即使值为 0 时没有转换 v
+        if (ConstValue::is_literal(constexp->t))
+            root->c = constexp->c.cast(root->t == ir::Type::Float ? ir::Type::FloatLiteral : ir::Type::IntLiteral);
         root->v = constexp->v;
         root->t = constexp->t;
         delete_temp_name();
@@ -357,14 +623,14 @@ void frontend::Analyzer::analysisConstInitVal(ConstInitVal *root, vector<Instruc
                 case ir::Type::Int:
                     // store:存储，op1:数组名，op2:下标，des:存入的数
                     instructions.push_back(new Instruction({root->v, ir::Type::IntPtr},
-                                                           {std::to_string(insert_index), ir::Type::IntLiteral},
+                                                           {ir::Symbol::int_literal(insert_index), ir::Type::IntLiteral},
                                                            {constinitval->v, ir::Type::IntLiteral},
                                                            Operator::store));
                     break;
                 case ir::Type::Float:
                     // store:存储，op1:数组名，op2:下标，des:存入的数
                     instructions.push_back(new Instruction({root->v, ir::Type::FloatPtr},
-                                                           {std::to_string(insert_index), ir::Type::IntLiteral},
+                                                           {ir::Symbol::int_literal(insert_index), ir::Type::IntLiteral},
                                                            {constinitval->v, ir::Type::FloatLiteral},
                                                            Operator::store));
                     break;
@@ -384,7 +650,7 @@ void frontend::Analyzer::analysisConstInitVal(ConstInitVal *root, vector<Instruc
 
 // VarDecl -> BType VarDef { ',' VarDef } ';'
 // VarDecl.t
-void frontend::Analyzer::analysisVarDecl(VarDecl *root, vector<Instruction *> &instructions)
+void frontend::Analyzer::analysisVarDecl(FlatNode root, vector<Instruction *> &instructions)
 {
     GET_CHILD_PTR(btype, BType, 0);
     analysisBType(btype);
@@ -402,7 +668,7 @@ void frontend::Analyzer::analysisVarDecl(VarDecl *root, vector<Instruction *> &i
 
 // BType -> 'int' | 'float'
 // BType.t
-void frontend::Analyzer::analysisBType(BType *root)
+void frontend::Analyzer::analysisBType(FlatNode root)
 {
     GET_CHILD_PTR(term, Term, 0);
     switch (term->token.type)
@@ -420,7 +686,7 @@ void frontend::Analyzer::analysisBType(BType *root)
 
 // VarDef -> Ident { '[' ConstExp ']' } [ '=' InitVal ]
 // VarDef.arr_name
-void frontend::Analyzer::analysisVarDef(VarDef *root, vector<Instruction *> &instructions, ir::Type type)
+void frontend::Analyzer::analysisVarDef(FlatNode root, vector<Instruction *> &instructions, ir::Type type)
 {
     GET_CHILD_PTR(ident, Term, 0);
     root->arr_name = symbol_table.get_scoped_name(ident->token.value);
@@ -435,7 +701,8 @@ void frontend::Analyzer::analysisVarDef(VarDef *root, vector<Instruction *> &ins
         constexp->v = root->arr_name;
         constexp->t = type;
         analysisConstExp(constexp, instructions);
-        dimension.push_back(std::stoi(constexp->v));
+        assert(ConstValue::is_literal(constexp->t) && "array dimension is not a constant");
+        dimension.push_back(constexp->c.to_int());
     }
 
     int size = std::accumulate(dimension.begin(), dimension.end(), 1, std::multiplies<int>());
@@ -468,43 +735,26 @@ void frontend::Analyzer::analysisVarDef(VarDef *root, vector<Instruction *> &ins
         {
         case ir::Type::Int:
             // alloc:内存分配，op1:数组长度，op2:不使用，des:数组名，数组名被视为一个指针。
-            instructions.push_back(new Instruction({std::to_string(size), ir::Type::IntLiteral},
+            instructions.push_back(new Instruction({ir::Symbol::int_literal(size), ir::Type::IntLiteral},
                                                    {},
                                                    {root->arr_name, ir::Type::IntPtr},
                                                    Operator::alloc));
             type = ir::Type::IntPtr;
-            // 初始化数组
-            for (int insert_index = 0; insert_index < size; insert_index++)
-            {
-                // store:存储，op1:数组名，op2:下标，des:存入的数
-                instructions.push_back(new Instruction({root->arr_name, ir::Type::IntPtr},
-                                                       {std::to_string(insert_index), ir::Type::IntLiteral},
-                                                       {"0", ir::Type::IntLiteral},
-                                                       Operator::store));
-            }
             break;
         case ir::Type::Float:
             // alloc:内存分配，op1:数组长度，op2:不使用，des:数组名，数组名被视为一个指针。
-            instructions.push_back(new Instruction({std::to_string(size), ir::Type::IntLiteral},
+            instructions.push_back(new Instruction({ir::Symbol::int_literal(size), ir::Type::IntLiteral},
                                                    {},
                                                    {root->arr_name, ir::Type::FloatPtr},
                                                    Operator::alloc));
             type = ir::Type::FloatPtr;
-            // 初始化数组
-            for (int insert_index = 0; insert_index < size; insert_index++)
-            {
-                // store:存储，op1:数组名，op2:下标，des:存入的数
-                instructions.push_back(new Instruction({root->arr_name, ir::Type::FloatPtr},
-                                                       {std::to_string(insert_index), ir::Type::IntLiteral},
-                                                       {"0.0", ir::Type::FloatLiteral},
-                                                       Operator::store));
-            }
             break;
         default:
             break;
         }
     }
 
+    size_t begin = instructions.size();
     if (NODE_IS(INITVAL, root->children.size() - 1)) // 如果有初始化值
     {
         GET_CHILD_PTR(initval, InitVal, root->children.size() - 1);
@@ -512,6 +762,9 @@ void frontend::Analyzer::analysisVarDef(VarDef *root, vector<Instruction *> &ins
         initval->t = type;
         analysisInitVal(initval, instructions);
     }
+    // 初始化数组, 没有初始值的元素为 0
+    if (dimension.size())
+        init_array({root->arr_name, type}, size, begin, instructions);
 
     symbol_table.add_operand(ident->token.value,
                              {Operand(root->arr_name, type),
@@ -522,7 +775,7 @@ void frontend::Analyzer::analysisVarDef(VarDef *root, vector<Instruction *> &ins
 // ConstExp.is_computable: true
 // ConstExp.v
 // ConstExp.t
-void frontend::Analyzer::analysisConstExp(ConstExp *root, vector<Instruction *> &instructions)
+void frontend::Analyzer::analysisConstExp(FlatNode root, vector<Instruction *> &instructions)
 {
     GET_CHILD_PTR(addexp, AddExp, 0);
     COPY_EXP_NODE(root, addexp);
@@ -534,7 +787,7 @@ void frontend::Analyzer::analysisConstExp(ConstExp *root, vector<Instruction *>
 // InitVal.is_computable
 // InitVal.v
 // InitVal.t
-void frontend::Analyzer::analysisInitVal(InitVal *root, vector<Instruction *> &instructions)
+void frontend::Analyzer::analysisInitVal(FlatNode root, vector<Instruction *> &instructions)
 {
     if (NODE_IS(EXP, 0))
     {
@@ -543,7 +796,7 @@ void frontend::Analyzer::analysisInitVal(InitVal *root, vector<Instruction *> &i
         exp->t = root->t; // Int or Float
         analysisExp(exp, instructions);
 
-        if (!(exp->v == "0" || exp->v == "0.0"))
+        if (!(ConstValue::is_literal(exp->t) && exp->c.is_zero()))
         {
             switch (root->t)
             {
@@ -551,7 +804,8 @@ void frontend::Analyzer::analysisInitVal(InitVal *root, vector<Instruction *> &i
                 if (exp->t == ir::Type::FloatLiteral)
                 {
                     exp->t = ir::Type::IntLiteral;
-                    exp->v = std::to_string((int)std::stof(exp->v));
+                    exp->c = exp->c.cast(ir::Type::IntLiteral);
+                    exp->v = exp->c.to_symbol();
                 }
                 else if (exp->t == ir::Type::Float)
                 {
@@ -572,7 +826,8 @@ void frontend::Analyzer::analysisInitVal(InitVal *root, vector<Instruction *> &i
                 if (exp->t == ir::Type::IntLiteral)
                 {
                     exp->t = ir::Type::FloatLiteral;
-                    exp->v = std::to_string((float)std::stoi(exp->v));
+                    exp->c = exp->c.cast(ir::Type::FloatLiteral);
+                    exp->v = exp->c.to_symbol();
                 }
                 else if (exp->t == ir::Type::Int)
                 {
@@ -596,6 +851,7 @@ void frontend::Analyzer::analysisInitVal(InitVal *root, vector<Instruction *> &i
 
         root->v = exp->v;
         root->t = exp->t;
+        root->c = exp->c;
         delete_temp_name();
     }
     else
@@ -611,7 +867,7 @@ void frontend::Analyzer::analysisInitVal(InitVal *root, vector<Instruction *> &i
                 analysisInitVal(initval, instructions);
                 // store:存储，op1:数组名，op2:下标，des:存入的数
                 instructions.push_back(new Instruction({root->v, root->t},
-                                                       {std::to_string(insert_index), ir::Type::IntLiteral},
+                                                       {ir::Symbol::int_literal(insert_index), ir::Type::IntLiteral},
                                                        {initval->v, initval->t},
                                                        Operator::store));
                 insert_index += 1;
@@ -628,7 +884,7 @@ void frontend::Analyzer::analysisInitVal(InitVal *root, vector<Instruction *> &i
 // FuncDef -> FuncType Ident '(' [FuncFParams] ')' Block
 // FuncDef.n;
 // FuncDef.t;
-void frontend::Analyzer::analysisFuncDef(FuncDef *root)
+void frontend::Analyzer::analysisFuncDef(FlatNode root)
 {
     // 生成函数返回值类型
     GET_CHILD_PTR(functype, FuncType, 0);
@@ -656,7 +912,7 @@ void frontend::Analyzer::analysisFuncDef(FuncDef *root)
 }
 
 // FuncType -> 'void' | 'int' | 'float'
-void frontend::Analyzer::analysisFuncType(FuncType *root, ir::Type &returnType)
+void frontend::Analyzer::analysisFuncType(FlatNode root, ir::Type &returnType)
 {
     GET_CHILD_PTR(term, Term, 0);
 
@@ -677,7 +933,7 @@ void frontend::Analyzer::analysisFuncType(FuncType *root, ir::Type &returnType)
 }
 
 // FuncFParams -> FuncFParam { ',' FuncFParam }
-void frontend::Analyzer::analysisFuncFParams(FuncFParams *root, vector<Operand> &params)
+void frontend::Analyzer::analysisFuncFParams(FlatNode root, vector<Operand> &params)
 {
     for (size_t i = 0; i < root->children.size(); i++)
     {
@@ -690,7 +946,7 @@ void frontend::Analyzer::analysisFuncFParams(FuncFParams *root, vector<Operand>
 }
 
 // FuncFParam -> BType Ident ['[' ']' { '[' Exp ']' }]
-void frontend::Analyzer::analysisFuncFParam(FuncFParam *root, vector<Operand> &params)
+void frontend::Analyzer::analysisFuncFParam(FlatNode root, vector<Operand> &params)
 {
     GET_CHILD_PTR(btype, BType, 0);
     analysisBType(btype);
@@ -730,7 +986,7 @@ void frontend::Analyzer::analysisFuncFParam(FuncFParam *root, vector<Operand> &p
 }
 
 // Block -> '{' { BlockItem } '}'
-void frontend::Analyzer::analysisBlock(Block *root, vector<Instruction *> &instructions)
+void frontend::Analyzer::analysisBlock(FlatNode root, vector<Instruction *> &instructions)
 {
     for (size_t i = 1; i < root->children.size() - 1; i++)
     {
@@ -741,7 +997,7 @@ void frontend::Analyzer::analysisBlock(Block *root, vector<Instruction *> &instr
 }
 
 // BlockItem -> Decl | Stmt
-void frontend::Analyzer::analysisBlockItem(BlockItem *root, std::vector<Instruction *> &instructions)
+void frontend::Analyzer::analysisBlockItem(FlatNode root, std::vector<Instruction *> &instructions)
 {
     if (NODE_IS(DECL, 0)) // 如果是声明
     {
@@ -755,6 +1011,45 @@ void frontend::Analyzer::analysisBlockItem(BlockItem *root, std::vector<Instruct
     }
 }
 
+// 整型比较运算取反, 不是整型比较时为 __unuse__
+Operator inverse_compare(Operator op)
+{
+    switch (op)
+    {
+    case Operator::eq:
+        return Operator::neq;
+    case Operator::neq:
+        return Operator::eq;
+    case Operator::lss:
+        return Operator::geq;
+    case Operator::geq:
+        return Operator::lss;
+    case Operator::leq:
+        return Operator::gtr;
+    case Operator::gtr:
+        return Operator::leq;
+    default:
+        return Operator::__unuse__;
+    }
+}
+
+// 添加一条跳转指令, 它的偏移量由 patch_jumps 回填
+void add_jump(vector<Instruction *> &instructions, vector<size_t> &jumps, Operand cond = Operand())
+{
+    jumps.push_back(instructions.size());
+    instructions.push_back(new Instruction(cond,
+                                           {},
+                                           {ir::Symbol::int_literal(0), ir::Type::IntLiteral},
+                                           Operator::_goto));
+}
+
+// 回填跳转指令, 使它们跳到 instructions[target]
+void patch_jumps(vector<Instruction *> &instructions, const vector<size_t> &jumps, size_t target)
+{
+    for (auto i : jumps)
+        instructions[i]->des.name = ir::Symbol::int_literal(int(target) - int(i));
+}
+
 // Stmt -> LVal '=' Exp ';'
 //       | Block
 //       | 'if' '(' Cond ')' Stmt [ 'else' Stmt ]
@@ -765,7 +1060,7 @@ void frontend::Analyzer::analysisBlockItem(BlockItem *root, std::vector<Instruct
 //       | [Exp] ';'
 // Stmt.jump_eow;
 // Stmt.jump_bow;
-void frontend::Analyzer::analysisStmt(Stmt *root, std::vector<Instruction *> &instructions)
+void frontend::Analyzer::analysisStmt(FlatNode root, std::vector<Instruction *> &instructions)
 {
     if (NODE_IS(LVAL, 0)) // 如果是赋值语句
     {
@@ -805,20 +1100,14 @@ void frontend::Analyzer::analysisStmt(Stmt *root, std::vector<Instruction *> &in
         {
         case TokenType::IFTK: // 'if' '(' Cond ')' Stmt [ 'else' Stmt ]
         {
-            GET_CHILD_PTR(cond, Cond, 2);
-            cond->v = get_temp_name();
-            cond->t = ir::Type::null; // 初始化为null
-            analysisCond(cond, instructions);
             // op1:跳转条件，整形变量(条件跳转)或null(无条件跳转)
             // op2:不使用
             // des:常量，值为跳转相对目前pc的偏移量
 
-            // 当条件为真时跳转到if_true_stmt（下下条指令）
-            // 否则继续执行下一条指令，下一条指令也应为跳转指令，指向if_true_stmt结束之后的指令
-            instructions.push_back(new Instruction({cond->v, cond->t},
-                                                   {},
-                                                   {"2", ir::Type::IntLiteral},
-                                                   Operator::_goto));
+            // 当条件为真时顺序执行if_true_stmt, 否则跳转到if_true_stmt结束之后的指令
+            GET_CHILD_PTR(cond, Cond, 2);
+            vector<size_t> false_jumps;
+            analysisCond(cond, instructions, false_jumps);
 
             vector<Instruction *> if_true_instructions;
             GET_CHILD_PTR(if_true_stmt, Stmt, 4);
@@ -832,39 +1121,23 @@ void frontend::Analyzer::analysisStmt(Stmt *root, std::vector<Instruction *> &in
                 // 执行完if_true_stmt后跳转到if_false_stmt后面
                 if_true_instructions.push_back(new Instruction({},
                                                                {},
-                                                               {std::to_string(if_false_instructions.size() + 1), ir::Type::IntLiteral},
+                                                               {ir::Symbol::int_literal(if_false_instructions.size() + 1), ir::Type::IntLiteral},
                                                                Operator::_goto));
             }
 
-            // 执行完if_true_stmt后跳转到if_false_stmt/if-else代码段（此时无if_false_stmt）后面
-            instructions.push_back(new Instruction({},
-                                                   {},
-                                                   {std::to_string(if_true_instructions.size() + 1), ir::Type::IntLiteral},
-                                                   Operator::_goto));
             instructions.insert(instructions.end(), if_true_instructions.begin(), if_true_instructions.end());
+            patch_jumps(instructions, false_jumps, instructions.size());
             instructions.insert(instructions.end(), if_false_instructions.begin(), if_false_instructions.end());
-
-            delete_temp_name();
             break;
         }
         case TokenType::WHILETK: // 'while' '(' Cond ')' Stmt
         {
+            // 先执行cond，如果为真则顺序执行while_stmt, 否则跳转到while_stmt后面
             GET_CHILD_PTR(cond, Cond, 2);
-            cond->v = get_temp_name();
-            cond->t = ir::Type::null; // 初始化为null
-            vector<Instruction *> cond_instructions;
-            analysisCond(cond, cond_instructions);
-            // op1:跳转条件，整形变量(条件跳转)或null(无条件跳转)
-            // op2:不使用
-            // des:常量，值为跳转相对目前pc的偏移量
-
-            // 先执行cond，如果为真则执行while_stmt，跳转到下下条（跳过下一条指令）
-            // 否则执行下一条，跳转到while_stmt后面
-            instructions.insert(instructions.end(), cond_instructions.begin(), cond_instructions.end());
-            instructions.push_back(new Instruction({cond->v, cond->t},
-                                                   {},
-                                                   {"2", ir::Type::IntLiteral},
-                                                   Operator::_goto));
+            size_t cond_begin = instructions.size();
+            vector<size_t> false_jumps;
+            analysisCond(cond, instructions, false_jumps);
+            int cond_size = instructions.size() - cond_begin;
 
             GET_CHILD_PTR(stmt, Stmt, 4);
             vector<Instruction *> while_instructions;
@@ -873,36 +1146,29 @@ void frontend::Analyzer::analysisStmt(Stmt *root, std::vector<Instruction *> &in
             // 执行完while_stmt后跳回到cond的第一条
             while_instructions.push_back(new Instruction({},
                                                          {},
-                                                         {std::to_string(-int(while_instructions.size() + 2 + cond_instructions.size())), ir::Type::IntLiteral},
-                                                         // +2是因为while_stmt前面分别还有2条跳转指令
+                                                         {ir::Symbol::int_literal(-int(while_instructions.size() + cond_size)), ir::Type::IntLiteral},
                                                          Operator::_goto));
 
-            // 跳转到while_stmt后面
-            instructions.push_back(new Instruction({},
-                                                   {},
-                                                   {std::to_string(while_instructions.size() + 1), ir::Type::IntLiteral},
-                                                   Operator::_goto));
-
             for (size_t i = 0; i < while_instructions.size(); i++)
             {
                 if (while_instructions[i]->op == Operator::__unuse__ && while_instructions[i]->op1.name == "1")
                 {
                     while_instructions[i] = new Instruction({},
                                                             {},
-                                                            {std::to_string(int(while_instructions.size()) - i), ir::Type::IntLiteral},
+                                                            {ir::Symbol::int_literal(int(while_instructions.size()) - i), ir::Type::IntLiteral},
                                                             Operator::_goto);
                 }
                 else if (while_instructions[i]->op == Operator::__unuse__ && while_instructions[i]->op1.name == "2")
                 {
                     while_instructions[i] = new Instruction({},
                                                             {},
-                                                            {std::to_string(-int(i + 2 + cond_instructions.size())), ir::Type::IntLiteral},
+                                                            {ir::Symbol::int_literal(-int(i + cond_size)), ir::Type::IntLiteral},
                                                             Operator::_goto);
                 }
             }
 
             instructions.insert(instructions.end(), while_instructions.begin(), while_instructions.end());
-            delete_temp_name();
+            patch_jumps(instructions, false_jumps, instructions.size());
             break;
         }
         case TokenType::BREAKTK: // 'break' ';'
@@ -952,113 +1218,118 @@ void frontend::Analyzer::analysisStmt(Stmt *root, std::vector<Instruction *> &in
 }
 
 // Cond -> LOrExp
-// Cond.is_computable
-// Cond.v
-// Cond.t
-void frontend::Analyzer::analysisCond(Cond *root, std::vector<Instruction *> &instructions)
+// Cond 生成为跳转而不是 0/1 的值: 为真时顺序执行后面的指令, 为假时跳走, false_jumps 中的跳转由调用者回填
+void frontend::Analyzer::analysisCond(FlatNode root, std::vector<Instruction *> &instructions, vector<size_t> &false_jumps)
 {
     GET_CHILD_PTR(lorexp, LOrExp, 0);
-    COPY_EXP_NODE(root, lorexp);
-    analysisLOrExp(lorexp, instructions);
-    COPY_EXP_NODE(lorexp, root);
+    vector<size_t> true_jumps;
+    analysisLOrExp(lorexp, instructions, true_jumps, false_jumps);
+    patch_jumps(instructions, true_jumps, instructions.size());
 }
 
 // LOrExp -> LAndExp [ '||' LOrExp ]
-// LOrExp.is_computable
-// LOrExp.v
-// LOrExp.t
-void frontend::Analyzer::analysisLOrExp(LOrExp *root, std::vector<Instruction *> &instructions)
+// 除最后一个外, 每个 LAndExp 为真时跳到 true_jumps, 为假时顺序执行下一个 LAndExp;
+// 最后一个 LAndExp 为真时顺序执行, 为假时跳到 false_jumps
+// LOrExp 链用循环代替递归
+void frontend::Analyzer::analysisLOrExp(FlatNode head, std::vector<Instruction *> &instructions, vector<size_t> &true_jumps, vector<size_t> &false_jumps)
 {
-    GET_CHILD_PTR(landexp, LAndExp, 0);
-    COPY_EXP_NODE(root, landexp);
-    analysisLAndExp(landexp, instructions);
-    COPY_EXP_NODE(landexp, root);
-
-    for (size_t i = 2; i < root->children.size(); i += 2) // 如果有多个LOrExp
+    for (NodeId id = head->id; id != FlatAst::NONE;)
     {
-        GET_CHILD_PTR(lorexp, LOrExp, i);
-        vector<Instruction *> second_lor_instructions;
-        lorexp->v = get_temp_name();
-        lorexp->t = ir::Type::Int; // 初始化为Int
-        analysisLOrExp(lorexp, second_lor_instructions);
-
-        if (root->t == ir::Type::IntLiteral && lorexp->t == ir::Type::IntLiteral)
+        FlatNode root = ast->get_node(id);
+        GET_CHILD_PTR(landexp, LAndExp, 0);
+        id = FlatAst::NONE;
+        if (root->children.size() > 2) // 如果有多个LOrExp
         {
-            root->v = std::to_string(std::stoi(root->v) || std::stoi(lorexp->v));
-            return;
+            GET_CHILD_PTR(lorexp, LOrExp, 2);
+            id = lorexp->id;
         }
 
-        second_lor_instructions.push_back(new Instruction({root->v, root->t},
-                                                          {lorexp->v, lorexp->t},
-                                                          {root->v, ir::Type::Int},
-                                                          Operator::_or));
-
-        // 如果第一个操作数为1，跳过后面的操作数
-        instructions.push_back(new Instruction({root->v, root->t},
-                                               {},
-                                               {std::to_string(second_lor_instructions.size() + 1), ir::Type::IntLiteral},
-                                               Operator::_goto));
-
-        instructions.insert(instructions.end(), second_lor_instructions.begin(), second_lor_instructions.end());
-        delete_temp_name();
+        vector<size_t> next_jumps; // 跳到下一个 LAndExp
+        bool is_last = id == FlatAst::NONE;
+        bool jumped = analysisLAndExp(landexp, instructions, is_last, true_jumps, is_last ? false_jumps : next_jumps);
+        patch_jumps(instructions, next_jumps, instructions.size());
+        // 后面的 LAndExp 执行不到
+        if (jumped && next_jumps.empty())
+            break;
     }
 }
 
 // LAndExp -> EqExp [ '&&' LAndExp ]
-// LAndExp.is_computable
-// LAndExp.v
-// LAndExp.t
-void frontend::Analyzer::analysisLAndExp(LAndExp *root, vector<Instruction *> &instructions)
+// 每个 EqExp 为假时跳到 false_jumps, 为真时顺序执行下一个 EqExp;
+// 如果 LAndExp 不是 LOrExp 的最后一个, 最后一个 EqExp 为真时跳到 true_jumps, 为假时顺序执行
+// 能取反的比较运算被取反, 这样只需要一条跳转
+// LAndExp 链用循环代替递归
+// @return 是否总是跳走, 后面的指令不会被顺序执行
+bool frontend::Analyzer::analysisLAndExp(FlatNode head, vector<Instruction *> &instructions, bool is_last, vector<size_t> &true_jumps, vector<size_t> &false_jumps)
 {
-    GET_CHILD_PTR(eqexp, EqExp, 0);
-    COPY_EXP_NODE(root, eqexp);
-    analysisEqExp(eqexp, instructions);
-    COPY_EXP_NODE(eqexp, root);
-
-    for (size_t i = 2; i < root->children.size(); i += 2) // 如果有多个LAndExp
+    for (NodeId id = head->id; id != FlatAst::NONE;)
     {
-        GET_CHILD_PTR(landexp, LAndExp, i);
-        vector<Instruction *> second_and_instructions;
-        landexp->v = get_temp_name();
-        landexp->t = ir::Type::Int; // 初始化为Int
-        analysisLAndExp(landexp, second_and_instructions);
+        FlatNode root = ast->get_node(id);
+        GET_CHILD_PTR(eqexp, EqExp, 0);
+        eqexp->v = get_temp_name();
+        eqexp->t = ir::Type::Int; // 初始化为Int
+        size_t begin = instructions.size();
+        analysisEqExp(eqexp, instructions);
+        Operand value(eqexp->v, eqexp->t);
+        delete_temp_name();
 
-        if (root->t == ir::Type::IntLiteral && landexp->t == ir::Type::IntLiteral)
+        id = FlatAst::NONE;
+        if (root->children.size() > 2) // 如果有多个LAndExp
         {
-            root->v = std::to_string(std::stoi(root->v) && std::stoi(landexp->v));
-            return;
+            GET_CHILD_PTR(landexp, LAndExp, 2);
+            id = landexp->id;
         }
 
-        second_and_instructions.push_back(new Instruction({root->v, root->t},
-                                                          {landexp->v, landexp->t},
-                                                          {root->v, ir::Type::Int},
-                                                          Operator::_and));
-
-        auto opposite = get_temp_name();
-        // 对第一个操作数取反
-        instructions.push_back(new Instruction({root->v, root->t},
-                                               {},
-                                               {opposite, ir::Type::Int},
-                                               Operator::_not));
-
-        // 如果第一个操作数为0（取反为1），跳过后面的操作数
-        instructions.push_back(new Instruction({opposite, ir::Type::Int},
-                                               {},
-                                               {std::to_string(second_and_instructions.size() + 1), ir::Type::IntLiteral},
-                                               Operator::_goto));
-
-        instructions.insert(instructions.end(), second_and_instructions.begin(), second_and_instructions.end());
-
-        delete_temp_name();
-        delete_temp_name();
+        if (id == FlatAst::NONE && !is_last) // 为真时跳走
+        {
+            if (!ConstValue::is_literal(value.type))
+            {
+                add_jump(instructions, true_jumps, value);
+            }
+            else if (!fold_unary(TokenType::NOT, eqexp->c).i)
+            {
+                add_jump(instructions, true_jumps);
+                return true;
+            }
+        }
+        else // 为假时跳走
+        {
+            Instruction *last = instructions.size() > begin ? instructions.back() : nullptr;
+            if (ConstValue::is_literal(value.type))
+            {
+                if (fold_unary(TokenType::NOT, eqexp->c).i)
+                {
+                    // 不是 LOrExp 的最后一个时, 为假就是顺序执行
+                    if (!is_last)
+                        return false;
+                    add_jump(instructions, false_jumps);
+                    return true;
+                }
+            }
+            else if (last && value.name.is_vreg() && last->des.name == value.name && inverse_compare(last->op) != Operator::__unuse__)
+            {
+                last->op = inverse_compare(last->op);
+                add_jump(instructions, false_jumps, value);
+            }
+            else
+            {
+                // 为真时跳过下一条跳转
+                instructions.push_back(new Instruction(value,
+                                                       {},
+                                                       {ir::Symbol::int_literal(2), ir::Type::IntLiteral},
+                                                       Operator::_goto));
+                add_jump(instructions, false_jumps);
+            }
+        }
     }
+    return false;
 }
 
 // EqExp -> RelExp { ('==' | '!=') RelExp }
 // EqExp.is_computable
 // EqExp.v
 // EqExp.t
-void frontend::Analyzer::analysisEqExp(EqExp *root, vector<Instruction *> &instructions)
+void frontend::Analyzer::analysisEqExp(FlatNode root, vector<Instruction *> &instructions)
 {
     GET_CHILD_PTR(relexp, RelExp, 0);
     COPY_EXP_NODE(root, relexp);
@@ -1071,20 +1342,12 @@ void frontend::Analyzer::analysisEqExp(EqExp *root, vector<Instruction *> &instr
         analysisRelExp(relexp, instructions);
 
         GET_CHILD_PTR(term, Term, i - 1);
-        if (root->t == ir::Type::IntLiteral && relexp->t == ir::Type::IntLiteral)
+        if (ConstValue::is_literal(root->t) && ConstValue::is_literal(relexp->t))
         {
-            switch (term->token.type)
-            {
-            case TokenType::EQL:
-                root->v = std::to_string(std::stoi(root->v) == std::stoi(relexp->v));
-                break;
-            case TokenType::NEQ:
-                root->v = std::to_string(std::stoi(root->v) != std::stoi(relexp->v));
-                break;
-            default:
-                assert(false);
-                break;
-            }
+            assert((term->token.type == TokenType::EQL || term->token.type == TokenType::NEQ) && "EqExp operator is not '==' or '!='");
+            root->c = fold_binary(term->token.type, root->c, relexp->c);
+            root->t = ir::Type::IntLiteral;
+            root->v = root->c.to_symbol();
         }
         else
         {
@@ -1122,7 +1385,7 @@ void frontend::Analyzer::analysisEqExp(EqExp *root, vector<Instruction *> &instr
 // RelExp.is_computable
 // RelExp.v
 // RelExp.t
-void frontend::Analyzer::analysisRelExp(RelExp *root, vector<Instruction *> &instructions)
+void frontend::Analyzer::analysisRelExp(FlatNode root, vector<Instruction *> &instructions)
 {
     // std::cout << "RelExp: " + toString(root->t) + " " + root->v << std::endl;
     GET_CHILD_PTR(addexp, AddExp, 0);
@@ -1139,26 +1402,11 @@ void frontend::Analyzer::analysisRelExp(RelExp *root, vector<Instruction *> &ins
 
         GET_CHILD_PTR(term, Term, i - 1);
         // std::cout << toString(root->t) + " " + root->v + " " + toString(term->token.type) + " " + toString(addexp->t) + " " + addexp->v << std::endl;
-        if (root->t == ir::Type::IntLiteral && addexp->t == ir::Type::IntLiteral)
+        if (ConstValue::is_literal(root->t) && ConstValue::is_literal(addexp->t))
         {
-
-            switch (term->token.type)
-            {
-            case TokenType::LSS:
-                root->v = std::to_string(std::stoi(root->v) < std::stoi(addexp->v));
-                break;
-            case TokenType::LEQ:
-                root->v = std::to_string(std::stoi(root->v) <= std::stoi(addexp->v));
-                break;
-            case TokenType::GTR:
-                root->v = std::to_string(std::stoi(root->v) > std::stoi(addexp->v));
-                break;
-            case TokenType::GEQ:
-                root->v = std::to_string(std::stoi(root->v) >= std::stoi(addexp->v));
-                break;
-            default:
-                break;
-            }
+            root->c = fold_binary(term->token.type, root->c, addexp->c);
+            root->t = ir::Type::IntLiteral;
+            root->v = root->c.to_symbol();
         }
         else
         {
@@ -1211,7 +1459,7 @@ void frontend::Analyzer::analysisRelExp(RelExp *root, vector<Instruction *> &ins
 // Exp.is_computable
 // Exp.v
 // Exp.t
-void frontend::Analyzer::analysisExp(Exp *root, vector<Instruction *> &instructions)
+void frontend::Analyzer::analysisExp(FlatNode root, vector<Instruction *> &instructions)
 {
     GET_CHILD_PTR(addexp, AddExp, 0);
     COPY_EXP_NODE(root, addexp);
@@ -1223,7 +1471,7 @@ void frontend::Analyzer::analysisExp(Exp *root, vector<Instruction *> &instructi
 // AddExp.is_computable
 // AddExp.v
 // AddExp.t
-void frontend::Analyzer::analysisAddExp(AddExp *root, std::vector<Instruction *> &instructions)
+void frontend::Analyzer::analysisAddExp(FlatNode root, std::vector<Instruction *> &instructions)
 {
     GET_CHILD_PTR(mulexp, MulExp, 0);
     COPY_EXP_NODE(root, mulexp);
@@ -1278,12 +1526,11 @@ void frontend::Analyzer::analysisAddExp(AddExp *root, std::vector<Instruction *>
             break;
 
         case ir::Type::IntLiteral:
-            if (mulexp->t == ir::Type::IntLiteral)
+            if (ConstValue::is_literal(mulexp->t))
             {
-                if (term->token.type == TokenType::PLUS)
-                    root->v = std::to_string(std::stoi(root->v) + std::stoi(mulexp->v));
-                else
-                    root->v = std::to_string(std::stoi(root->v) - std::stoi(mulexp->v));
+                root->c = fold_binary(term->token.type, root->c, mulexp->c);
+                root->t = root->c.t;
+                root->v = root->c.to_symbol();
             }
             else
             {
@@ -1353,12 +1600,10 @@ void frontend::Analyzer::analysisAddExp(AddExp *root, std::vector<Instruction *>
             root->t = ir::Type::Float;
             break;
         case ir::Type::FloatLiteral:
-            if (mulexp->t == ir::Type::FloatLiteral)
+            if (ConstValue::is_literal(mulexp->t))
             {
-                if (term->token.type == TokenType::PLUS)
-                    root->v = std::to_string(std::stof(root->v) + std::stof(mulexp->v));
-                else
-                    root->v = std::to_string(std::stof(root->v) - std::stof(mulexp->v));
+                root->c = fold_binary(term->token.type, root->c, mulexp->c);
+                root->v = root->c.to_symbol();
             }
             else
             {
@@ -1404,7 +1649,7 @@ void frontend::Analyzer::analysisAddExp(AddExp *root, std::vector<Instruction *>
 // MulExp.is_computable
 // MulExp.v
 // MulExp.t
-void frontend::Analyzer::analysisMulExp(MulExp *root, std::vector<Instruction *> &instructions)
+void frontend::Analyzer::analysisMulExp(FlatNode root, std::vector<Instruction *> &instructions)
 {
     GET_CHILD_PTR(unaryexp, UnaryExp, 0);
     COPY_EXP_NODE(root, unaryexp);
@@ -1467,23 +1712,11 @@ void frontend::Analyzer::analysisMulExp(MulExp *root, std::vector<Instruction *>
             break;
 
         case ir::Type::IntLiteral:
-            if (unaryexp->t == ir::Type::IntLiteral)
+            if (ConstValue::is_literal(unaryexp->t))
             {
-                switch (term->token.type)
-                {
-                case TokenType::MULT:
-                    root->v = std::to_string(std::stoi(root->v) * std::stoi(unaryexp->v));
-                    break;
-                case TokenType::DIV:
-                    root->v = std::to_string(std::stoi(root->v) / std::stoi(unaryexp->v));
-                    break;
-                case TokenType::MOD:
-                    root->v = std::to_string(std::stoi(root->v) % std::stoi(unaryexp->v));
-                    break;
-                default:
-                    break;
-                }
-                root->t = ir::Type::IntLiteral;
+                root->c = fold_binary(term->token.type, root->c, unaryexp->c);
+                root->v = root->c.to_symbol();
+                root->t = root->c.t;
             }
             else
             {
@@ -1569,20 +1802,10 @@ void frontend::Analyzer::analysisMulExp(MulExp *root, std::vector<Instruction *>
             }
             break;
         case ir::Type::FloatLiteral:
-            if (unaryexp->t == ir::Type::FloatLiteral)
+            if (ConstValue::is_literal(unaryexp->t))
             {
-                switch (term->token.type)
-                {
-                case TokenType::MULT:
-                    root->v = std::to_string(std::stof(root->v) * std::stof(unaryexp->v));
-                    break;
-                case TokenType::DIV:
-                    root->v = std::to_string(std::stof(root->v) / std::stof(unaryexp->v));
-                    break;
-                case TokenType::MOD:
-                    root->v = std::to_string(std::fmod(std::stof(root->v), std::stof(unaryexp->v)));
-                    break;
-                }
+                root->c = fold_binary(term->token.type, root->c, unaryexp->c);
+                root->v = root->c.to_symbol();
                 root->t = ir::Type::FloatLiteral;
             }else{
                 if(unaryexp->t == ir::Type::Int || unaryexp->t == ir::Type::IntLiteral){
@@ -1635,7 +1858,7 @@ void frontend::Analyzer::analysisMulExp(MulExp *root, std::vector<Instruction *>
 // UnaryExp.is_computable
 // UnaryExp.v
 // UnaryExp.t
-void frontend::Analyzer::analysisUnaryExp(UnaryExp *root, std::vector<Instruction *> &instructions)
+void frontend::Analyzer::analysisUnaryExp(FlatNode root, std::vector<Instruction *> &instructions)
 {
     if (NODE_IS(PRIMARYEXP, 0)) // 如果是PrimaryExp
     {
@@ -1705,7 +1928,8 @@ void frontend::Analyzer::analysisUnaryExp(UnaryExp *root, std::vector<Instructio
                 break;
             case ir::Type::IntLiteral:
                 root->t = ir::Type::IntLiteral;
-                root->v = std::to_string(-std::stoi(root->v));
+                root->c = fold_unary(TokenType::MINU, root->c);
+                root->v = root->c.to_symbol();
                 break;
             case ir::Type::Float:
                 instructions.push_back(new Instruction({"0.0", ir::Type::FloatLiteral},
@@ -1717,7 +1941,8 @@ void frontend::Analyzer::analysisUnaryExp(UnaryExp *root, std::vector<Instructio
                 break;
             case ir::Type::FloatLiteral:
                 root->t = ir::Type::FloatLiteral;
-                root->v = std::to_string(-std::stof(root->v));
+                root->c = fold_unary(TokenType::MINU, root->c);
+                root->v = root->c.to_symbol();
                 break;
             default:
                 assert(0);
@@ -1754,14 +1979,15 @@ void frontend::Analyzer::analysisUnaryExp(UnaryExp *root, std::vector<Instructio
 
 // UnaryOp -> '+' | '-' | '!'
 // TokenType op;
-void frontend::Analyzer::analysisUnaryOp(UnaryOp *root, std::vector<Instruction *> &instructions)
+void frontend::Analyzer::analysisUnaryOp(FlatNode root, std::vector<Instruction *> &instructions)
 {
+    // op 在 FlatNode 中由 Term 的类型得到
     GET_CHILD_PTR(term, Term, 0);
-    root->op = term->token.type;
+    assert(root->op == term->token.type);
 }
 
 // FuncRParams -> Exp { ',' Exp }
-void frontend::Analyzer::analysisFuncRParams(FuncRParams *root, vector<Operand> &params, vector<Instruction *> &instructions)
+void frontend::Analyzer::analysisFuncRParams(FlatNode root, vector<Operand> &params, vector<Instruction *> &instructions)
 {
     size_t index = 0;
     for (size_t i = 0; i < root->children.size(); i += 2)
@@ -1782,7 +2008,7 @@ void frontend::Analyzer::analysisFuncRParams(FuncRParams *root, vector<Operand>
 // PrimaryExp.is_computable
 // PrimaryExp.v
 // PrimaryExp.t
-void frontend::Analyzer::analysisPrimaryExp(PrimaryExp *root, std::vector<Instruction *> &instructions)
+void frontend::Analyzer::analysisPrimaryExp(FlatNode root, std::vector<Instruction *> &instructions)
 {
     if (NODE_IS(NUMBER, 0))
     {
@@ -1812,7 +2038,7 @@ void frontend::Analyzer::analysisPrimaryExp(PrimaryExp *root, std::vector<Instru
 // LVal.v
 // LVal.t
 // LVal.i array index, legal if t is IntPtr or FloatPtr
-void frontend::Analyzer::analysisLVal(LVal *root, vector<Instruction *> &instructions, bool is_left = false)
+void frontend::Analyzer::analysisLVal(FlatNode root, vector<Instruction *> &instructions, bool is_left = false)
 {
     GET_CHILD_PTR(ident, Term, 0);
     auto var = symbol_table.get_ste(ident->token.value);
@@ -1878,6 +2104,7 @@ void frontend::Analyzer::analysisLVal(LVal *root, vector<Instruction *> &instruc
             root->is_computable = true;
             root->t = var.operand.type;
             root->v = var.operand.name;
+            root->c = var.value;
             break;
         default:
             root->t = var.operand.type;
@@ -1912,7 +2139,7 @@ void frontend::Analyzer::analysisLVal(LVal *root, vector<Instruction *> &instruc
             int mul_dim = std::accumulate(var.dimension.begin() + i + 1, var.dimension.end(), 1, std::multiplies<int>());
             auto temp_name = get_temp_name();
             instructions.push_back(new Instruction(load_index[i],
-                                                   {std::to_string(mul_dim), ir::Type::IntLiteral},
+                                                   {ir::Symbol::int_literal(mul_dim), ir::Type::IntLiteral},
                                                    {temp_name, ir::Type::Int},
                                                    Operator::mul));
             instructions.push_back(new Instruction(res_index,
@@ -1945,32 +2172,19 @@ void frontend::Analyzer::analysisLVal(LVal *root, vector<Instruction *> &instruc
 // Number.is_computable = true;
 // Number.v
 // Number.t
-void frontend::Analyzer::analysisNumber(Number *root, vector<Instruction *> &)
+void frontend::Analyzer::analysisNumber(FlatNode root, vector<Instruction *> &)
 {
     root->is_computable = true;
 
     GET_CHILD_PTR(term, Term, 0);
 
+    // 整数常量的名字是十进制的值, 浮点数常量保留原来的写法
+    root->c = ConstValue::of_token(term->token);
     switch (term->token.type)
     {
     case TokenType::INTLTR: // 整数常量
         root->t = Type::IntLiteral;
-        if (term->token.value.substr(0, 2) == "0x")
-        {
-            root->v = std::to_string(std::stoi(term->token.value, nullptr, 16));
-        }
-        else if (term->token.value.substr(0, 2) == "0b")
-        {
-            root->v = std::to_string(std::stoi(term->token.value, nullptr, 2));
-        }
-        else if (term->token.value.substr(0, 1) == "0" && !(term->token.value.substr(0, 2) == "0x") && !(term->token.value.substr(0, 2) == "0b"))
-        {
-            root->v = std::to_string(std::stoi(term->token.value, nullptr, 8));
-        }
-        else
-        {
-            root->v = term->token.value;
-        }
+        root->v = root->c.to_symbol();
         break;
     case TokenType::FLOATLTR: // 浮点数常量
         root->t = Type::FloatLiteral;
@@ -1980,3 +2194,120 @@ void frontend::Analyzer::analysisNumber(Number *root, vector<Instruction *> &)
         break;
     }
 }
+
+#ifdef DEBUG_STRESS_CHAIN
+#include "front/syntax.h"
+#include <chrono>
+#include <string>
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+// a program with n global declarations, and an AddExp, a LOrExp and a LAndExp of n operands
+std::string make_chain_source(int n)
+{
+    std::string src;
+    for (int i = 0; i < n; i++)
+        src += "int g" + std::to_string(i) + " = " + std::to_string(i) + ";\n";
+    std::string add = "a", lor = "a", land = "a";
+    for (int i = 1; i < n; i++)
+    {
+        add += " + a";
+        lor += " || a";
+        land += " && a";
+    }
+    src += "int main() {\n    int a = getint();\n    int b = " + add + ";\n    if (" + lor + ") b = 1;\n    if (" + land + ") b = 2;\n    return b;\n}\n";
+    return src;
+}
+
+// parse and analyze the program of n, return the milliseconds
+double run_chain(int n)
+{
+    std::string src = make_chain_source(n);
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<frontend::Token> tokens;
+    frontend::DFA dfa;
+    frontend::TokenView tk;
+    bool in_comment = false;
+    uint32_t pos = 0;
+    while (frontend::scan_token(src.data(), src.size(), pos, in_comment, dfa, tk))
+        tokens.push_back({tk.type, ir::Symbol(src.data() + tk.offset, tk.length)});
+    if (dfa.finish(src.data(), src.size(), tk))
+        tokens.push_back({tk.type, ir::Symbol(src.data() + tk.offset, tk.length)});
+    frontend::FlatAst flat;
+    frontend::Parser(tokens).get_flat_abstract_syntax_tree(flat);
+    frontend::Analyzer analyzer;
+    ir::Program program = analyzer.get_ir_program(flat);
+    assert(program.globalVal.size() == (size_t)n && "in stress_chain, globals are lost");
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+
+void *run_chain_thread(void *arg)
+{
+    int n = *static_cast<int *>(arg);
+    for (int k = n; k <= 4 * n; k *= 2)
+        std::cout << "stress chain: n = " << k << ", " << run_chain(k) << " ms" << std::endl;
+    return nullptr;
+}
+
+// the time should grow linearly with n, and the chains are analysed with a small stack,
+// which a recursion of one frame per CompUnit or per '||' would overflow
+void stress_chain()
+{
+    int n = 20000;
+#ifndef _WIN32
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, 256 * 1024);
+    pthread_t thread;
+    int ret = pthread_create(&thread, &attr, run_chain_thread, &n);
+    assert(ret == 0 && "in stress_chain, can not create thread");
+    pthread_join(thread, nullptr);
+    pthread_attr_destroy(&attr);
+#else
+    run_chain_thread(&n);
+#endif
+}
+#endif
+
+#ifdef DEBUG_SYMBOL_TABLE
+#include <chrono>
+
+// deeply nested blocks, each declares a local and shadows a global, then the globals are looked up in the innermost block,
+// the time of a lookup should not grow with the depth
+void bench_symbol_table()
+{
+    const int globals = 1000, lookups = 1000000;
+    std::vector<ir::Symbol> names;
+    for (int i = 0; i < globals; i++)
+        names.push_back("g" + std::to_string(i));
+    for (int depth = 16; depth <= 16384; depth *= 8)
+    {
+        frontend::SymbolTable table;
+        table.add_scope();
+        for (auto name : names)
+            table.add_operand(name, {Operand(table.get_scoped_name(name), ir::Type::Int), {}});
+        auto begin = std::chrono::steady_clock::now();
+        for (int d = 0; d < depth; d++)
+        {
+            table.add_scope();
+            ir::Symbol local = "l" + std::to_string(d);
+            table.add_operand(local, {Operand(table.get_scoped_name(local), ir::Type::Int), {}});
+            table.add_operand(names[d % globals], {Operand(table.get_scoped_name(names[d % globals]), ir::Type::Int), {}});
+        }
+        auto nested = std::chrono::steady_clock::now();
+        size_t found = 0;
+        for (int i = 0; i < lookups; i++)
+            found += table.get_operand(names[i % globals]).name.id() != 0;
+        auto looked = std::chrono::steady_clock::now();
+        for (int d = 0; d < depth; d++)
+            table.exit_scope();
+        auto exited = std::chrono::steady_clock::now();
+        assert(found == (size_t)lookups && table.bindings.size() == (size_t)globals && table.get_operand(names[0]).name == "g0_1" &&
+               "in bench_symbol_table, scopes are not restored");
+        std::cout << "symbol table: depth " << depth << ", enter " << std::chrono::duration<double, std::milli>(nested - begin).count()
+                  << " ms, " << std::chrono::duration<double, std::nano>(looked - nested).count() / lookups << " ns per lookup, exit "
+                  << std::chrono::duration<double, std::milli>(exited - looked).count() << " ms" << std::endl;
+    }
+}
+#endif
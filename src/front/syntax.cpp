@@ -2,6 +2,17 @@
 
 #include <iostream>
 #include <cassert>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <functional>
+
+// #define DEBUG_AST_ARENA
+// #define DEBUG_PARALLEL_PARSE
+
+#ifdef DEBUG_AST_ARENA
+#include <chrono>
+#endif
 
 using frontend::AddExp;
 using frontend::AstNode;
@@ -40,15 +51,19 @@ using frontend::VarDef;
 
 #define DEBUG_PARSER
 #define TODO assert(0 && "todo")
-#define CUR_TOKEN_IS(tk_type) (token_stream[index].type == TokenType::tk_type)
+#define CUR_TOKEN_IS(tk_type) (token_stream.peek().type == TokenType::tk_type)
 #define PARSE_TOKEN(tk_type) root->children.push_back(parseTerm(root, TokenType::tk_type))
 // name是要创建的AST节点的名称，type是要解析的语法元素的类型。
-#define PARSE(name, type)       \
-    auto name = new type(root); \
-    assert(parse##type(name));  \
+#define PARSE(name, type)                  \
+    auto name = arena->create<type>(root); \
+    assert(parse##type(name));             \
     root->children.push_back(name);
 
-Parser::Parser(const std::vector<frontend::Token> &tokens) : index(0), token_stream(tokens)
+Parser::Parser(const std::vector<frontend::Token> &tokens, frontend::AstArena *arena) : token_stream(tokens), own_arena(), arena(arena ? arena : &own_arena)
+{
+}
+
+Parser::Parser(frontend::Scanner &scanner, frontend::AstArena *arena) : token_stream(scanner), own_arena(), arena(arena ? arena : &own_arena)
 {
 }
 
@@ -56,52 +71,116 @@ Parser::~Parser() {}
 
 CompUnit *Parser::get_abstract_syntax_tree()
 {
-    CompUnit *root = new CompUnit();
+#ifdef DEBUG_AST_ARENA
+    auto begin = std::chrono::steady_clock::now();
+#endif
+    CompUnit *root = arena->create<CompUnit>();
 
     parseCompUnit(root);
 
+#ifdef DEBUG_AST_ARENA
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    std::cout << "ast arena: " << arena->node_count() << " nodes, " << arena->bytes_used() << " bytes, parsed in " << ms << " ms" << std::endl;
+#endif
     return root;
 }
 
+void Parser::get_flat_abstract_syntax_tree(frontend::FlatAst &ast)
+{
+    assert(ast.size() == 0 && "in Parser::get_flat_abstract_syntax_tree, ast is not empty");
+#ifdef DEBUG_AST_ARENA
+    auto begin = std::chrono::steady_clock::now();
+    size_t max_bytes = 0;
+#endif
+    frontend::AstArena item_arena;
+    frontend::AstArena *saved_arena = arena;
+    arena = &item_arena;
+
+    // the same as parseCompUnit(), but the CompUnit chain is built in ast directly
+    frontend::NodeId unit = ast.add_node(frontend::NodeType::COMPUINT);
+    while (true)
+    {
+        AstNode *item = nullptr;
+        if (CUR_TOKEN_IS(CONSTTK) || ((CUR_TOKEN_IS(INTTK) || CUR_TOKEN_IS(FLOATTK)) && token_stream.peek(2).type != TokenType::LPARENT))
+        {
+            Decl *decl = arena->create<Decl>();
+            assert(parseDecl(decl));
+            item = decl;
+        }
+        else if (CUR_TOKEN_IS(VOIDTK) || CUR_TOKEN_IS(INTTK) || CUR_TOKEN_IS(FLOATTK))
+        {
+            FuncDef *func_def = arena->create<FuncDef>();
+            assert(parseFuncDef(func_def));
+            item = func_def;
+        }
+        if (!item)
+            break;
+
+        bool more = CUR_TOKEN_IS(CONSTTK) || CUR_TOKEN_IS(VOIDTK) || CUR_TOKEN_IS(INTTK) || CUR_TOKEN_IS(FLOATTK);
+        frontend::NodeId first = ast.add_children(unit, more ? 2 : 1);
+        ast.set_type(first, item->type);
+        ast.copy_subtree(item, first);
+#ifdef DEBUG_AST_ARENA
+        max_bytes = std::max(max_bytes, arena->bytes_used());
+#endif
+        arena->reset();
+        if (!more)
+            break;
+        unit = first + 1;
+        ast.set_type(unit, frontend::NodeType::COMPUINT);
+    }
+    arena = saved_arena;
+
+#ifdef DEBUG_AST_ARENA
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    std::cout << "flat ast: " << ast.size() << " nodes, " << ast.bytes_used() << " bytes, largest item " << max_bytes
+              << " bytes in arena, parsed in " << ms << " ms" << std::endl;
+#endif
+}
+
 Term *Parser::parseTerm(AstNode *parent, TokenType expected)
 {
-    if (token_stream[index].type == expected)
+    if (token_stream.peek().type == expected)
     {
-        // std::cout << "TERM: " << toString(parent->type) << "\t" << token_stream[index].value << '\n';
-        Term *node = new Term(token_stream[index], parent);
-        index++;
+        // std::cout << "TERM: " << toString(parent->type) << "\t" << token_stream.peek().value << '\n';
+        Term *node = arena->create<Term>(token_stream.peek(), parent);
+        token_stream.advance();
         return node;
     }
 }
 
 // CompUnit -> (Decl | FuncDef) [CompUnit]
+// the CompUnit chain is built in a loop instead of recursion, so a file with many top-level nodes does not use the stack
 bool Parser::parseCompUnit(CompUnit *root)
 {
-
-    if (CUR_TOKEN_IS(CONSTTK))
-    {
-        PARSE(decl, Decl);
-    }
-    else if (CUR_TOKEN_IS(VOIDTK))
-    {
-        PARSE(func_def, FuncDef);
-    }
-    else if (CUR_TOKEN_IS(INTTK) || CUR_TOKEN_IS(FLOATTK))
+    while (true)
     {
-
-        if (index < token_stream.size() - 2 && token_stream[index + 2].type == TokenType::LPARENT)
+        if (CUR_TOKEN_IS(CONSTTK))
+        {
+            PARSE(decl, Decl);
+        }
+        else if (CUR_TOKEN_IS(VOIDTK))
         {
             PARSE(func_def, FuncDef);
         }
-        else
+        else if (CUR_TOKEN_IS(INTTK) || CUR_TOKEN_IS(FLOATTK))
         {
-            PARSE(decl, Decl);
+
+            if (token_stream.peek(2).type == TokenType::LPARENT)
+            {
+                PARSE(func_def, FuncDef);
+            }
+            else
+            {
+                PARSE(decl, Decl);
+            }
         }
-    }
 
-    if (CUR_TOKEN_IS(CONSTTK) || CUR_TOKEN_IS(VOIDTK) || CUR_TOKEN_IS(INTTK) || CUR_TOKEN_IS(FLOATTK))
-    {
-        PARSE(comp_unit, CompUnit);
+        if (!(CUR_TOKEN_IS(CONSTTK) || CUR_TOKEN_IS(VOIDTK) || CUR_TOKEN_IS(INTTK) || CUR_TOKEN_IS(FLOATTK)))
+            break;
+        CompUnit *comp_unit = arena->create<CompUnit>(root);
+        root->children.push_back(comp_unit);
+        root = comp_unit;
     }
 
     return true;
@@ -474,14 +553,14 @@ bool Parser::parseStmt(Stmt *root)
     {
         // Stmt -> Exp ';'
         //      -> Ident '(' [FuncRParams] ')'
-        if (index < token_stream.size() - 1 && token_stream[index + 1].type == TokenType::LPARENT)
+        if (token_stream.peek(1).type == TokenType::LPARENT)
         {
             PARSE(exp, Exp);
             PARSE_TOKEN(SEMICN);
         }
         // Stmt -> LVal '=' Exp ';'
         //      -> Ident {'[' Exp ']'}
-        else if (index < token_stream.size() - 1 && (token_stream[index + 1].type == TokenType::LBRACK) || (token_stream[index + 1].type == TokenType::ASSIGN))
+        else if (token_stream.peek(1).type == TokenType::LBRACK || token_stream.peek(1).type == TokenType::ASSIGN)
         {
             PARSE(l_val, LVal);
             PARSE_TOKEN(ASSIGN);
@@ -585,7 +664,7 @@ bool Parser::parseUnaryExp(UnaryExp *root)
     else if (CUR_TOKEN_IS(IDENFR))
     {
         // UnaryExp -> Ident '(' [FuncRParams] ')'
-        if (index < token_stream.size() - 1 && token_stream[index + 1].type == TokenType::LPARENT)
+        if (token_stream.peek(1).type == TokenType::LPARENT)
         {
             PARSE_TOKEN(IDENFR);
             PARSE_TOKEN(LPARENT);
@@ -752,30 +831,38 @@ bool Parser::parseEqExp(EqExp *root)
 }
 
 // LAndExp -> EqExp [ '&&' LAndExp ]
+// the nested LAndExp is parsed in a loop instead of recursion, so a long chain does not use the stack
 bool Parser::parseLAndExp(LAndExp *root)
 {
-
-    PARSE(eq_exp, EqExp);
-
-    if (CUR_TOKEN_IS(AND))
+    while (true)
     {
+        PARSE(eq_exp, EqExp);
+
+        if (!CUR_TOKEN_IS(AND))
+            break;
         PARSE_TOKEN(AND);
-        PARSE(l_and_exp, LAndExp);
+        LAndExp *l_and_exp = arena->create<LAndExp>(root);
+        root->children.push_back(l_and_exp);
+        root = l_and_exp;
     }
 
     return true;
 }
 
 // LOrExp -> LAndExp [ '||' LOrExp ]
+// the nested LOrExp is parsed in a loop instead of recursion, so a long chain does not use the stack
 bool Parser::parseLOrExp(LOrExp *root)
 {
-
-    PARSE(l_and_exp, LAndExp);
-
-    if (CUR_TOKEN_IS(OR))
+    while (true)
     {
+        PARSE(l_and_exp, LAndExp);
+
+        if (!CUR_TOKEN_IS(OR))
+            break;
         PARSE_TOKEN(OR);
-        PARSE(l_or_exp, LOrExp);
+        LOrExp *l_or_exp = arena->create<LOrExp>(root);
+        root->children.push_back(l_or_exp);
+        root = l_or_exp;
     }
 
     return true;
@@ -793,6 +880,205 @@ bool Parser::parseConstExp(ConstExp *root)
 void Parser::log(AstNode *node)
 {
 #ifdef DEBUG_PARSER
-    std::cout << "in parse" << toString(node->type) << ", cur_token_type::" << toString(token_stream[index].type) << ", token_val::" << token_stream[index].value << '\n';
+    std::cout << "in parse" << toString(node->type) << ", cur_token_type::" << toString(token_stream.peek().type) << ", token_val::" << token_stream.peek().value << '\n';
+#endif
+}
+
+// the tokens [begin, end) of a top-level Decl or FuncDef
+struct ItemRange
+{
+    uint32_t begin;
+    uint32_t end;
+    bool is_func;
+};
+
+bool is_item_begin(frontend::TokenType type)
+{
+    return type == frontend::TokenType::CONSTTK || type == frontend::TokenType::VOIDTK || type == frontend::TokenType::INTTK ||
+           type == frontend::TokenType::FLOATTK;
+}
+
+// find the top-level Decl and FuncDef as parseCompUnit() chooses them, the tokens after the last one are not parsed
+std::vector<ItemRange> find_items(const std::vector<frontend::TokenView> &tokens)
+{
+    using frontend::TokenType;
+    std::vector<ItemRange> items;
+    uint32_t n = tokens.size();
+    for (uint32_t i = 0; i < n && is_item_begin(tokens[i].type);)
+    {
+        ItemRange item = {i, n, tokens[i].type == TokenType::VOIDTK || (tokens[i].type != TokenType::CONSTTK && i + 2 < n && tokens[i + 2].type == TokenType::LPARENT)};
+        uint32_t depth = 0;
+        for (uint32_t j = i; j < n; j++)
+        {
+            if (tokens[j].type == TokenType::LBRACE)
+            {
+                depth++;
+            }
+            else if (tokens[j].type == TokenType::RBRACE)
+            {
+                depth -= depth > 0;
+                if (item.is_func && depth == 0)
+                {
+                    item.end = j + 1;
+                    break;
+                }
+            }
+            else if (tokens[j].type == TokenType::SEMICN && !item.is_func && depth == 0)
+            {
+                item.end = j + 1;
+                break;
+            }
+        }
+        items.push_back(item);
+        i = item.end;
+    }
+    return items;
+}
+
+// parse the tokens, which refer to src, into ast with thread_num threads
+void parse_tokens_parallel(const char *src, const std::vector<frontend::TokenView> &tokens, frontend::FlatAst &ast, uint32_t thread_num)
+{
+    using frontend::NodeId;
+    using frontend::NodeType;
+    std::vector<ItemRange> items = find_items(tokens);
+    std::vector<frontend::FlatAst> parts(items.size());
+
+    // every worker has its own arena, which is reset after every top-level node is copied into its part
+    std::atomic<uint32_t> next_item(0);
+    std::atomic<bool> failed(false);
+    auto parse_worker = [&]()
+    {
+        frontend::AstArena arena;
+        std::vector<frontend::Token> slice;
+        for (uint32_t k; !failed && (k = next_item++) < items.size();)
+        {
+            slice.clear();
+            for (uint32_t i = items[k].begin; i < items[k].end; i++)
+                slice.push_back({tokens[i].type, ir::Symbol(src + tokens[i].offset, tokens[i].length)});
+            Parser parser(slice, &arena);
+            AstNode *item;
+            if (items[k].is_func)
+            {
+                FuncDef *func_def = arena.create<FuncDef>();
+                assert(parser.parseFuncDef(func_def));
+                item = func_def;
+            }
+            else
+            {
+                Decl *decl = arena.create<Decl>();
+                assert(parser.parseDecl(decl));
+                item = decl;
+            }
+            // the node should take exactly its tokens, or the serial parser may split the tokens in another way
+            if (parser.token_stream.peek().type != frontend::TokenType::ENDTK)
+                failed = true;
+            else
+                parts[k].copy_subtree(item, parts[k].add_node(item->type));
+            arena.reset();
+        }
+    };
+    auto run_workers = [&](std::function<void()> worker)
+    {
+        std::vector<std::thread> pool;
+        for (uint32_t t = 1; t < std::min<size_t>(thread_num, items.size()); t++)
+            pool.emplace_back(worker);
+        worker();
+        for (auto &t : pool)
+            t.join();
+    };
+    run_workers(parse_worker);
+
+    if (failed)
+    {
+        std::vector<frontend::Token> all(tokens.size());
+        for (size_t i = 0; i < tokens.size(); i++)
+            all[i] = {tokens[i].type, ir::Symbol(src + tokens[i].offset, tokens[i].length)};
+        Parser parser(all);
+        parser.get_flat_abstract_syntax_tree(ast);
+        return;
+    }
+
+    // lay out the nodes like Parser::get_flat_abstract_syntax_tree(), so the ids are the same:
+    // the children of the k-th CompUnit, which are the k-th item and the next CompUnit, are followed by the subtree of the k-th item
+    std::vector<NodeId> item_id(items.size()), base(items.size());
+    std::vector<uint32_t> token_base(items.size());
+    size_t node_num = 1, token_num = 0;
+    for (size_t k = 0; k < items.size(); k++)
+    {
+        item_id[k] = node_num;
+        node_num += k + 1 < items.size() ? 2 : 1;
+        base[k] = node_num;
+        node_num += parts[k].size() - 1;
+        token_base[k] = token_num;
+        token_num += parts[k].tokens.size();
+    }
+    assert(node_num < frontend::FlatAst::NONE && "in parse_parallel, too many nodes");
+    ast.resize(node_num, token_num);
+    ast.set_type(0, NodeType::COMPUINT);
+    for (size_t k = 0; k < items.size(); k++)
+    {
+        NodeId unit = k ? item_id[k - 1] + 1 : 0;
+        ast.set_type(unit, NodeType::COMPUINT);
+        ast.first_child[unit] = item_id[k];
+        ast.child_count[unit] = k + 1 < items.size() ? 2 : 1;
+        if (k + 1 < items.size())
+            ast.next_sibling[item_id[k]] = item_id[k] + 1;
+    }
+
+    // the parts are copied to their places at the same time
+    next_item = 0;
+    auto copy_worker = [&]()
+    {
+        for (uint32_t k; (k = next_item++) < items.size();)
+        {
+            ast.copy_part(item_id[k], base[k], token_base[k], parts[k]);
+            parts[k] = frontend::FlatAst();
+        }
+    };
+    run_workers(copy_worker);
+}
+
+#ifdef DEBUG_PARALLEL_PARSE
+#include <chrono>
+
+// scaling benchmark: parse the tokens with 1 to 16 threads, check the result with serial parsing
+void bench_parallel_parse(const char *src, const std::vector<frontend::TokenView> &tokens)
+{
+    // the tokens are interned while timing, as parse_tokens_parallel() does
+    frontend::FlatAst serial;
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<frontend::Token> all(tokens.size());
+    for (size_t i = 0; i < tokens.size(); i++)
+        all[i] = {tokens[i].type, ir::Symbol(src + tokens[i].offset, tokens[i].length)};
+    Parser(all).get_flat_abstract_syntax_tree(serial);
+    auto end = std::chrono::steady_clock::now();
+    double base = std::chrono::duration<double, std::milli>(end - begin).count();
+    std::cout << "parallel parse: " << tokens.size() << " tokens, " << find_items(tokens).size() << " items, " << serial.size()
+              << " nodes, serial " << base << " ms" << std::endl;
+    for (uint32_t thread_num = 1; thread_num <= 16; thread_num *= 2)
+    {
+        frontend::FlatAst result;
+        begin = std::chrono::steady_clock::now();
+        parse_tokens_parallel(src, tokens, result, thread_num);
+        end = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(end - begin).count();
+        assert(result.kind == serial.kind && result.token == serial.token && result.first_child == serial.first_child &&
+               result.next_sibling == serial.next_sibling && result.child_count == serial.child_count &&
+               result.tokens.size() == serial.tokens.size() && "in bench_parallel_parse, AST differs from serial result");
+        for (size_t i = 0; i < serial.tokens.size(); i++)
+            assert(result.tokens[i].type == serial.tokens[i].type && result.tokens[i].value == serial.tokens[i].value &&
+                   "in bench_parallel_parse, token differs from serial result");
+        std::cout << "  " << thread_num << " threads: " << ms << " ms, speedup " << base / ms << std::endl;
+    }
+}
+#endif
+
+void frontend::parse_parallel(Scanner &scanner, FlatAst &ast, uint32_t thread_num)
+{
+    assert(ast.size() == 0 && "in parse_parallel, ast is not empty");
+    std::vector<TokenView> tokens = scanner.run_mapped();
+    parse_tokens_parallel(scanner.get_source().data(), tokens, ast, thread_num ? thread_num : 1);
+#ifdef DEBUG_PARALLEL_PARSE
+    bench_parallel_parse(scanner.get_source().data(), tokens);
 #endif
 }
@@ -41,6 +41,7 @@ std::string frontend::toString(frontend::TokenType type){
     case TokenType::NEQ: return "NEQ";
     case TokenType::AND: return "AND";
     case TokenType::OR: return "OR";
+    case TokenType::ENDTK: return "ENDTK";
     default:
         assert(0 && "invalid token type");
         break;
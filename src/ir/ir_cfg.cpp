@@ -0,0 +1,280 @@
+#include "ir/ir_cfg.h"
+
+#include <cassert>
+#include <algorithm>
+#include <iostream>
+
+// #define DEBUG_CFG
+
+void ir::BasicBlock::remove_pred(size_t k) {
+    preds.erase(preds.begin() + k);
+    for (auto inst: insts) {
+        if (inst->op != Operator::phi)
+            break;
+        auto& incoming = static_cast<PhiInst*>(inst)->incomingList;
+        incoming.erase(incoming.begin() + k);
+    }
+}
+
+ir::CFG::CFG(const Function& func): entry(0), vreg_cnt(0) {
+    const auto& insts = func.InstVec;
+    size_t n = insts.size();
+
+    auto visit = [&](const Operand& op) {
+        if (op.name.is_vreg())
+            vreg_cnt = std::max(vreg_cnt, op.name.vreg_index() + 1);
+    };
+    for (const auto& param: func.ParameterList)
+        visit(param);
+    for (const Instruction* inst: insts) {
+        visit(inst->op1), visit(inst->op2), visit(inst->des);
+        if (inst->op == Operator::call)
+            for (const auto& arg: static_cast<const CallInst*>(inst)->argumentList)
+                visit(arg);
+    }
+
+    // 跳转目标, 跳转和 return 的下一条指令是基本块的开头; 跳转到函数末尾即跳转到 exit
+    std::vector<int64_t> target(n, -1);
+    std::vector<uint8_t> is_leader(n + 1, 0);
+    is_leader[0] = 1;
+    for (size_t i = 0; i < n; i++) {
+        if (insts[i]->op == Operator::_goto) {
+            assert(insts[i]->des.name.is_literal() && "in CFG, the offset of goto should be an int literal");
+            target[i] = (int64_t)i + insts[i]->des.name.int_value();
+            assert(target[i] >= 0 && target[i] <= (int64_t)n && "in CFG, goto out of the function");
+            is_leader[target[i]] = 1;
+            is_leader[i + 1] = 1;
+        }
+        else if (insts[i]->op == Operator::_return)
+            is_leader[i + 1] = 1;
+    }
+
+    // 入口块没有前驱, 第一条指令是跳转目标时在前面加一个空的入口块
+    bool entry_is_target = std::find(target.begin(), target.end(), 0) != target.end();
+    std::vector<uint32_t> block_of(n + 1);
+    uint32_t block_num = entry_is_target;
+    for (size_t i = 0; i < n; i++) {
+        if (is_leader[i])
+            block_num++;
+        block_of[i] = block_num - 1;
+    }
+    block_num = std::max(block_num, 1u);
+    exit = block_num;
+    block_of[n] = exit;
+    blocks.resize(block_num + 1);
+
+    for (size_t i = 0; i < n; i++) {
+        BasicBlock& block = blocks[block_of[i]];
+        Instruction* inst = insts[i];
+        if (inst->op == Operator::_goto) {
+            uint32_t to = block_of[target[i]], fall = block_of[i + 1];
+            // 跳转到下一个基本块的条件跳转与顺序执行相同
+            if (inst->op1.type != Type::null && to != fall) {
+                block.cond = inst->op1;
+                block.succs = {to, fall};
+            }
+            else
+                block.succs = {to};
+            continue;
+        }
+        block.insts.push_back(inst);
+        if (inst->op == Operator::_return)
+            block.succs = {exit};
+        else if (i + 1 == n || is_leader[i + 1])
+            block.succs = {block_of[i + 1]};
+    }
+    if (n == 0)
+        blocks[entry].succs = {exit};
+    if (entry_is_target)
+        blocks[entry].succs = {1};
+
+    for (uint32_t b = 0; b < blocks.size(); b++)
+        for (auto s: blocks[b].succs)
+            blocks[s].preds.push_back(b);
+
+#ifdef DEBUG_CFG
+    std::cout << draw();
+#endif
+}
+
+uint32_t ir::CFG::add_block() {
+    blocks.emplace_back();
+    return blocks.size() - 1;
+}
+
+void ir::CFG::add_edge(uint32_t from, uint32_t to) {
+    blocks[from].succs.push_back(to);
+    blocks[to].preds.push_back(from);
+}
+
+void ir::CFG::redirect_edge(uint32_t from, uint32_t old_to, uint32_t new_to) {
+    auto& succs = blocks[from].succs;
+    auto iter = std::find(succs.begin(), succs.end(), old_to);
+    assert(iter != succs.end() && "in CFG::redirect_edge, no such edge");
+    *iter = new_to;
+    auto& preds = blocks[old_to].preds;
+    blocks[old_to].remove_pred(std::find(preds.begin(), preds.end(), from) - preds.begin());
+    assert((blocks[new_to].insts.empty() || blocks[new_to].insts[0]->op != Operator::phi) &&
+           "in CFG::redirect_edge, the new successor has phi");
+    blocks[new_to].preds.push_back(from);
+}
+
+uint32_t ir::CFG::split_edge(uint32_t from, uint32_t to) {
+    uint32_t mid = add_block();
+    *std::find(blocks[from].succs.begin(), blocks[from].succs.end(), to) = mid;
+    *std::find(blocks[to].preds.begin(), blocks[to].preds.end(), from) = mid;
+    blocks[mid].preds = {from};
+    blocks[mid].succs = {to};
+    return mid;
+}
+
+ir::Symbol ir::CFG::new_vreg() {
+    return Symbol::vreg(vreg_cnt++);
+}
+
+std::vector<uint32_t> ir::CFG::reverse_post_order() const {
+    std::vector<uint32_t> order;
+    std::vector<uint8_t> visited(blocks.size(), 0);
+    // 用栈代替递归, 记录每个块下一个要访问的后继
+    std::vector<std::pair<uint32_t, uint32_t>> stack = {{entry, 0}};
+    visited[entry] = 1;
+    while (!stack.empty()) {
+        auto& top = stack.back();
+        const auto& succs = blocks[top.first].succs;
+        if (top.second < succs.size()) {
+            uint32_t s = succs[top.second++];
+            if (!visited[s]) {
+                visited[s] = 1;
+                stack.push_back({s, 0});
+            }
+        }
+        else {
+            order.push_back(top.first);
+            stack.pop_back();
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+bool ir::CFG::remove_unreachable() {
+    std::vector<uint32_t> new_id(blocks.size(), UINT32_MAX);
+    for (auto b: reverse_post_order())
+        new_id[b] = 0;
+    new_id[exit] = 0;
+    uint32_t n = 0;
+    for (uint32_t b = 0; b < blocks.size(); b++)
+        if (new_id[b] != UINT32_MAX)
+            new_id[b] = n++;
+    if (n == blocks.size())
+        return false;
+
+    for (uint32_t b = 0; b < blocks.size(); b++) {
+        if (new_id[b] == UINT32_MAX)
+            continue;
+        BasicBlock& block = blocks[b];
+        for (auto& s: block.succs)
+            s = new_id[s];
+        // 不可达的前驱被删除
+        for (size_t k = block.preds.size(); k-- > 0;) {
+            if (new_id[block.preds[k]] == UINT32_MAX)
+                block.remove_pred(k);
+            else
+                block.preds[k] = new_id[block.preds[k]];
+        }
+        if (new_id[b] != b)
+            blocks[new_id[b]] = std::move(block);
+    }
+    blocks.resize(n);
+    entry = new_id[entry];
+    exit = new_id[exit];
+    return true;
+}
+
+size_t ir::CFG::inst_count() const {
+    size_t n = 0;
+    for (const auto& block: blocks)
+        n += block.insts.size();
+    return n;
+}
+
+std::vector<uint32_t> ir::CFG::layout() const {
+    std::vector<uint32_t> order;
+    order.reserve(blocks.size());
+    for (uint32_t b = 0; b < blocks.size(); b++)
+        if (b != exit)
+            order.push_back(b);
+    order.push_back(exit);
+    return order;
+}
+
+size_t ir::CFG::jump_num(const std::vector<uint32_t>& order, size_t k) const {
+    const BasicBlock& block = blocks[order[k]];
+    uint32_t next = k + 1 < order.size() ? order[k + 1] : UINT32_MAX;
+    if (block.is_return() || block.succs.empty())
+        return 0;
+    if (block.cond.type != Type::null)
+        return 1 + (block.succs[1] != next);
+    return block.succs[0] != next;
+}
+
+size_t ir::CFG::lowered_size() const {
+    auto order = layout();
+    size_t n = 0;
+    for (size_t k = 0; k < order.size(); k++)
+        n += blocks[order[k]].insts.size() + jump_num(order, k);
+    return n;
+}
+
+void ir::CFG::lower(Function& func) const {
+    auto order = layout();
+
+    // 先计算每个块的开始位置, 再生成跳转
+    std::vector<size_t> start(blocks.size());
+    size_t n = 0;
+    for (size_t k = 0; k < order.size(); k++) {
+        start[order[k]] = n;
+        n += blocks[order[k]].insts.size() + jump_num(order, k);
+    }
+
+    auto jump_to = [&](const Operand& cond, uint32_t to, size_t index) {
+        return new Instruction(cond, Operand(), Operand(Symbol::int_literal((int32_t)((int64_t)start[to] - (int64_t)index)), Type::IntLiteral), Operator::_goto);
+    };
+    func.InstVec.clear();
+    func.InstVec.reserve(n);
+    for (size_t k = 0; k < order.size(); k++) {
+        const BasicBlock& block = blocks[order[k]];
+        assert((block.insts.empty() || block.insts[0]->op != Operator::phi) && "in CFG::lower, phi should be removed by out-of-ssa");
+        func.InstVec.insert(func.InstVec.end(), block.insts.begin(), block.insts.end());
+        size_t jumps = jump_num(order, k);
+        if (jumps == 0)
+            continue;
+        if (block.cond.type != Type::null) {
+            func.addInst(jump_to(block.cond, block.succs[0], func.InstVec.size()));
+            if (jumps == 2)
+                func.addInst(jump_to(Operand(), block.succs[1], func.InstVec.size()));
+        }
+        else
+            func.addInst(jump_to(Operand(), block.succs[0], func.InstVec.size()));
+    }
+    assert(func.InstVec.size() == n && "in CFG::lower, wrong number of instructions");
+}
+
+std::string ir::CFG::draw() const {
+    std::string res;
+    for (uint32_t b = 0; b < blocks.size(); b++) {
+        const BasicBlock& block = blocks[b];
+        res += "B" + std::to_string(b) + (b == exit ? " (exit)" : "") + ":\tpreds:";
+        for (auto p: block.preds)
+            res += " B" + std::to_string(p);
+        res += "\tsuccs:";
+        for (auto s: block.succs)
+            res += " B" + std::to_string(s);
+        res += "\n";
+        for (const Instruction* inst: block.insts)
+            res += "\t" + inst->draw() + "\n";
+        if (block.cond.type != Type::null)
+            res += "\tif " + block.cond.name + " goto B" + std::to_string(block.succs[0]) + "\n";
+    }
+    return res;
+}
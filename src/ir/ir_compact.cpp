@@ -0,0 +1,154 @@
+#include "ir/ir_compact.h"
+#include "ir/ir_instruction.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+// #define DEBUG_COMPACT_IR
+
+// the bits of a literal operand, a literal made from source text is parsed here once
+uint32_t literal_bits(const ir::Operand& op) {
+    if (op.name.is_literal()) {
+        if (op.name.is_float_literal()) {
+            float f = op.name.float_value();
+            uint32_t word;
+            memcpy(&word, &f, sizeof(word));
+            return word;
+        }
+        return (uint32_t)op.name.int_value();
+    }
+    const std::string& text = op.name.str();
+    if (op.type == ir::Type::FloatLiteral) {
+        float f = std::strtof(text.c_str(), nullptr);
+        uint32_t word;
+        memcpy(&word, &f, sizeof(word));
+        return word;
+    }
+    return (uint32_t)std::strtoll(text.c_str(), nullptr, 0);
+}
+
+ir::CompactFunction::CompactFunction(): name("null"), returnType(Type::null) {
+    add_operand(Operand());
+}
+
+ir::CompactFunction::CompactFunction(const Function& func): name(func.name), returnType(func.returnType) {
+    add_operand(Operand());
+    for (const auto& param: func.ParameterList)
+        params.push_back(add_operand(param));
+    insts.reserve(func.InstVec.size());
+    for (const Instruction* inst: func.InstVec) {
+        CompactInst ci = {(uint8_t)inst->op, 0, 0, add_operand(inst->op1), add_operand(inst->op2), add_operand(inst->des)};
+        if (inst->op == Operator::call) {
+            auto call_inst = dynamic_cast<const CallInst*>(inst);
+            assert(call_inst && "in CompactFunction, call is not a CallInst");
+            assert(call_inst->argumentList.size() <= UINT16_MAX && "in CompactFunction, too many arguments");
+            ci.op2 = args.size();
+            ci.argc = call_inst->argumentList.size();
+            for (const auto& arg: call_inst->argumentList)
+                args.push_back(add_operand(arg));
+        }
+        else if (inst->op == Operator::phi) {
+            auto phi_inst = dynamic_cast<const PhiInst*>(inst);
+            assert(phi_inst && "in CompactFunction, phi is not a PhiInst");
+            assert(phi_inst->incomingList.size() <= UINT16_MAX && "in CompactFunction, too many incoming values");
+            ci.op2 = args.size();
+            ci.argc = phi_inst->incomingList.size();
+            for (const auto& value: phi_inst->incomingList)
+                args.push_back(add_operand(value));
+        }
+        insts.push_back(ci);
+    }
+}
+
+uint32_t ir::CompactFunction::add_operand(const Operand& op) {
+    uint64_t key = (uint64_t)op.name.id() << 8 | (uint8_t)op.type;
+    auto iter = operand_index.find(key);
+    if (iter != operand_index.end())
+        return iter->second;
+    uint32_t id = operands.size();
+    operands.push_back(op);
+    values.push_back(op.type == Type::IntLiteral || op.type == Type::FloatLiteral ? literal_bits(op) : 0);
+    operand_index[key] = id;
+    return id;
+}
+
+ir::Function ir::CompactFunction::to_function() const {
+    Function func(name, returnType);
+    for (auto param: params)
+        func.ParameterList.push_back(operands[param]);
+    func.InstVec.reserve(insts.size());
+    for (const auto& ci: insts) {
+        if ((Operator)ci.op == Operator::call) {
+            std::vector<Operand> argument_list;
+            for (uint32_t i = ci.op2; i < ci.op2 + ci.argc; i++)
+                argument_list.push_back(operands[args[i]]);
+            func.addInst(new CallInst(operands[ci.op1], argument_list, operands[ci.des]));
+        }
+        else if ((Operator)ci.op == Operator::phi) {
+            std::vector<Operand> incoming_list;
+            for (uint32_t i = ci.op2; i < ci.op2 + ci.argc; i++)
+                incoming_list.push_back(operands[args[i]]);
+            func.addInst(new PhiInst(operands[ci.des], incoming_list));
+        }
+        else
+            func.addInst(new Instruction(operands[ci.op1], operands[ci.op2], operands[ci.des], (Operator)ci.op));
+    }
+    return func;
+}
+
+float ir::CompactFunction::float_value(uint32_t id) const {
+    float f;
+    memcpy(&f, &values[id], sizeof(f));
+    return f;
+}
+
+size_t ir::CompactFunction::bytes_used() const {
+    return params.size() * sizeof(uint32_t) + insts.size() * sizeof(CompactInst) + args.size() * sizeof(uint32_t) +
+           operands.size() * (sizeof(Operand) + sizeof(uint32_t));
+}
+
+ir::CompactProgram::CompactProgram() {}
+
+ir::CompactProgram::CompactProgram(const Program& program): globalVal(program.globalVal) {
+    functions.reserve(program.functions.size());
+    for (const auto& func: program.functions)
+        functions.emplace_back(func);
+
+#ifdef DEBUG_COMPACT_IR
+    Program origin = program;
+    assert(to_program().draw() == origin.draw() && "in CompactProgram, the program converted back differs");
+    size_t old_bytes = 0;
+    for (const auto& func: program.functions)
+        for (const Instruction* inst: func.InstVec) {
+            old_bytes += sizeof(Instruction*) + sizeof(Instruction);
+            if (auto call_inst = dynamic_cast<const CallInst*>(inst))
+                old_bytes += sizeof(CallInst) - sizeof(Instruction) + call_inst->argumentList.size() * sizeof(Operand);
+        }
+    std::cerr << "compact IR: " << inst_count() << " instructions, " << (double)old_bytes / inst_count()
+              << " -> " << (double)bytes_used() / inst_count() << " bytes per instruction" << std::endl;
+#endif
+}
+
+ir::Program ir::CompactProgram::to_program() const {
+    Program program;
+    for (const auto& func: functions)
+        program.addFunction(func.to_function());
+    program.globalVal = globalVal;
+    return program;
+}
+
+size_t ir::CompactProgram::inst_count() const {
+    size_t n = 0;
+    for (const auto& func: functions)
+        n += func.insts.size();
+    return n;
+}
+
+size_t ir::CompactProgram::bytes_used() const {
+    size_t n = 0;
+    for (const auto& func: functions)
+        n += func.bytes_used();
+    return n;
+}
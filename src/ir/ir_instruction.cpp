@@ -24,6 +24,19 @@ std::string ir::CallInst::draw() const {
     return res;
 }
 
+ir::PhiInst::PhiInst(const Operand &des, std::vector<Operand> incomingList)
+    : Instruction(Operand(), Operand(), des, Operator::phi), incomingList(incomingList) {}
+
+std::string ir::PhiInst::draw() const {
+    std::string res = "phi " + this->des.name + ", [";
+    for(const auto& value: incomingList)
+        res += value.name + ", ";
+    if(incomingList.size())
+        res = res.substr(0,res.size()-2);
+    res += "]";
+    return res;
+}
+
 std::string ir::Instruction::draw() const {
     switch (this->op) {
         case ir::Operator::_return:
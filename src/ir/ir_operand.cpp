@@ -4,4 +4,4 @@
 #include <utility>
 
 
-ir::Operand::Operand(std::string  n, Type t): name(std::move(n)), type(t) {}
+ir::Operand::Operand(Symbol n, Type t): name(n), type(t) {}
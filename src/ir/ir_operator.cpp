@@ -15,6 +15,9 @@ std::string toString(Operator t)
         case Operator::store: return "store";
         case Operator::getptr: return "getptr";
         case Operator::load: return "load";
+        case Operator::fill: return "fill";
+        case Operator::copy: return "copy";
+        case Operator::phi: return "phi";
         case Operator::def: return "def";
         case Operator::fdef: return "fdef";
         case Operator::mov: return "mov";
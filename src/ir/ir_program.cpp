@@ -3,6 +3,7 @@
 #include <vector>
 #include <string>
 #include <iostream>
+#include <cstring>
 
 
 ir::Program::Program(): functions(std::vector<ir::Function>()) {}
@@ -22,7 +23,17 @@ std::string ir::Program::draw() {
     }
     ret += "GVT:\n";
     for (auto i : this->globalVal) {
-        ret += "\t" + i.val.name + " " + toString(i.val.type) + " " + std::to_string(i.maxlen) + "\n";
+        ret += "\t" + i.val.name + " " + toString(i.val.type) + " " + std::to_string(i.maxlen);
+        if (i.init.size()) {
+            bool is_float = i.val.type == Type::Float || i.val.type == Type::FloatLiteral || i.val.type == Type::FloatPtr;
+            ret += " =";
+            for (auto word : i.init) {
+                float f;
+                memcpy(&f, &word, sizeof(f));
+                ret += " " + (is_float ? std::to_string(f) : std::to_string((int32_t)word));
+            }
+        }
+        ret += "\n";
     }
     return ret;
 }
\ No newline at end of file
@@ -0,0 +1,290 @@
+#include "ir/ir_symbol.h"
+
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cassert>
+
+namespace {
+
+struct SymbolEntry {
+    std::string text;
+    uint32_t hash;
+};
+
+// entries are stored in fixed size blocks which are never moved, so str() can read them without lock
+const uint32_t BLOCK_BITS = 12;
+const uint32_t BLOCK_SIZE = 1 << BLOCK_BITS;
+const uint32_t MAX_BLOCKS = 1 << 16;
+
+// a literal id is LITERAL_BIT | v for 0 <= v < POOLED_BIT, and LITERAL_BIT | POOLED_BIT | index in the literal pool for others
+const uint32_t POOLED_BIT = 0x20000000u;
+
+const char VREG_PREFIX[] = "temp_";
+const size_t VREG_PREFIX_LEN = sizeof(VREG_PREFIX) - 1;
+
+uint32_t fnv1a(const char* s, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// the text of a vreg, "temp_" and the decimal n
+size_t vreg_text(uint32_t n, char* buf) {
+    memcpy(buf, VREG_PREFIX, VREG_PREFIX_LEN);
+    char digits[10];
+    size_t len = 0;
+    do {
+        digits[len++] = '0' + n % 10;
+        n /= 10;
+    } while (n);
+    for (size_t i = 0; i < len; i++)
+        buf[VREG_PREFIX_LEN + i] = digits[len - 1 - i];
+    return VREG_PREFIX_LEN + len;
+}
+
+// if s is the text of a vreg, such as "temp_12" but not "temp_012", set n and return true
+bool parse_vreg(const char* s, size_t len, uint32_t& n) {
+    if (len <= VREG_PREFIX_LEN || len > VREG_PREFIX_LEN + 10 || memcmp(s, VREG_PREFIX, VREG_PREFIX_LEN) != 0)
+        return false;
+    if (s[VREG_PREFIX_LEN] == '0' && len > VREG_PREFIX_LEN + 1)
+        return false;
+    uint64_t v = 0;
+    for (size_t i = VREG_PREFIX_LEN; i < len; i++) {
+        if (s[i] < '0' || s[i] > '9')
+            return false;
+        v = v * 10 + (s[i] - '0');
+    }
+    if (v >= ir::Symbol::LITERAL_BIT)
+        return false;
+    n = v;
+    return true;
+}
+
+// if s is the decimal text of an int, such as "-12" but not "012" or "-0", set v and return true
+bool parse_int_literal(const char* s, size_t len, int32_t& v) {
+    size_t i = (len && s[0] == '-') ? 1 : 0;
+    if (len == i || len - i > 10 || (s[i] == '0' && (len - i > 1 || i == 1)))
+        return false;
+    int64_t value = 0;
+    for (; i < len; i++) {
+        if (s[i] < '0' || s[i] > '9')
+            return false;
+        value = value * 10 + (s[i] - '0');
+    }
+    if (s[0] == '-')
+        value = -value;
+    if (value < INT32_MIN || value > INT32_MAX)
+        return false;
+    v = value;
+    return true;
+}
+
+// the text of a literal, the same as std::to_string, a float which can not be read back from it has 9 significant digits
+std::string literal_text(bool is_float, uint32_t bits) {
+    if (!is_float)
+        return std::to_string((int32_t)bits);
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    std::string text = std::to_string(f);
+    if (std::strtof(text.c_str(), nullptr) != f) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.9g", f);
+        text = buf;
+    }
+    return text;
+}
+
+struct SymbolPool {
+    SymbolEntry* blocks[MAX_BLOCKS];
+    uint32_t count;
+    std::vector<uint32_t> slots;    // open addressing hash table, the value is id + 1, 0 means empty
+    std::mutex mtx;                 // intern may be called by several threads
+    std::vector<std::string*> vreg_blocks;  // texts of vregs, made when they are used, empty if not made
+    std::vector<uint64_t> literals;         // pooled literals, is_float << 32 | bits
+    std::unordered_map<uint64_t, uint32_t> literal_index;   // pooled literal -> index in literals
+    std::unordered_map<uint32_t, std::string> literal_texts;    // literal id -> text, made when it is used
+
+    SymbolPool(): blocks(), count(0), slots(1024, 0), vreg_blocks(), literals(), literal_index(), literal_texts() {
+        intern("", 0);
+    }
+
+    uint32_t make_id(const char* s, size_t len) {
+        uint32_t n;
+        if (parse_vreg(s, len, n))
+            return n | ir::Symbol::VREG_BIT;
+        int32_t v;
+        if (parse_int_literal(s, len, v))
+            return literal_id(false, v);
+        return intern(s, len);
+    }
+
+    uint32_t literal_id(bool is_float, uint32_t bits) {
+        if (!is_float && bits < POOLED_BIT)
+            return ir::Symbol::LITERAL_BIT | bits;
+        uint64_t key = (uint64_t)is_float << 32 | bits;
+        std::lock_guard<std::mutex> lock(mtx);
+        auto iter = literal_index.find(key);
+        if (iter != literal_index.end())
+            return iter->second;
+        assert(literals.size() < POOLED_BIT && "too many literals");
+        uint32_t id = ir::Symbol::LITERAL_BIT | POOLED_BIT | literals.size();
+        literals.push_back(key);
+        literal_index.insert({key, id});
+        return id;
+    }
+
+    // is_float << 32 | bits of a literal id
+    uint64_t literal(uint32_t id) {
+        if (!(id & POOLED_BIT))
+            return id & ~ir::Symbol::LITERAL_BIT;
+        std::lock_guard<std::mutex> lock(mtx);
+        return literals[id & ~(ir::Symbol::LITERAL_BIT | POOLED_BIT)];
+    }
+
+    const std::string& literal_str(uint32_t id) {
+        uint64_t key = literal(id);
+        std::lock_guard<std::mutex> lock(mtx);
+        auto iter = literal_texts.find(id);
+        if (iter == literal_texts.end())
+            iter = literal_texts.insert({id, literal_text(key >> 32, (uint32_t)key)}).first;
+        return iter->second;
+    }
+
+    const std::string& vreg_str(uint32_t n) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (vreg_blocks.size() <= (n >> BLOCK_BITS))
+            vreg_blocks.resize((n >> BLOCK_BITS) + 1, nullptr);
+        std::string*& block = vreg_blocks[n >> BLOCK_BITS];
+        if (!block)
+            block = new std::string[BLOCK_SIZE];
+        std::string& text = block[n & (BLOCK_SIZE - 1)];
+        if (text.empty()) {
+            char buf[VREG_PREFIX_LEN + 10];
+            text.assign(buf, vreg_text(n, buf));
+        }
+        return text;
+    }
+
+    SymbolEntry& entry(uint32_t id) {
+        return blocks[id >> BLOCK_BITS][id & (BLOCK_SIZE - 1)];
+    }
+
+    uint32_t intern(const char* s, size_t len) {
+        uint32_t h = fnv1a(s, len);
+        std::lock_guard<std::mutex> lock(mtx);
+        uint32_t mask = slots.size() - 1;
+        uint32_t i = h & mask;
+        for (; slots[i]; i = (i + 1) & mask) {
+            const SymbolEntry& e = entry(slots[i] - 1);
+            if (e.hash == h && e.text.size() == len && memcmp(e.text.data(), s, len) == 0)
+                return slots[i] - 1;
+        }
+        uint32_t id = count++;
+        assert((id >> BLOCK_BITS) < MAX_BLOCKS && "too many symbols");
+        if (!blocks[id >> BLOCK_BITS])
+            blocks[id >> BLOCK_BITS] = new SymbolEntry[BLOCK_SIZE];
+        entry(id).text.assign(s, len);
+        entry(id).hash = h;
+        slots[i] = id + 1;
+        // keep load factor under 1/2
+        if (count * 2 > slots.size())
+            rehash(slots.size() * 2);
+        return id;
+    }
+
+    void rehash(size_t size) {
+        std::vector<uint32_t> new_slots(size, 0);
+        uint32_t mask = size - 1;
+        for (uint32_t id = 0; id < count; id++) {
+            uint32_t i = entry(id).hash & mask;
+            while (new_slots[i])
+                i = (i + 1) & mask;
+            new_slots[i] = id + 1;
+        }
+        slots.swap(new_slots);
+    }
+};
+
+SymbolPool& pool() {
+    static SymbolPool p;
+    return p;
+}
+
+}
+
+ir::Symbol::Symbol(): _id(0) {}
+
+ir::Symbol::Symbol(const std::string& s): _id(pool().make_id(s.data(), s.size())) {}
+
+ir::Symbol::Symbol(const char* s): _id(pool().make_id(s, strlen(s))) {}
+
+ir::Symbol::Symbol(const char* s, size_t len): _id(pool().make_id(s, len)) {}
+
+ir::Symbol ir::Symbol::vreg(uint32_t n) {
+    assert(n < LITERAL_BIT && "too many vregs");
+    Symbol sym;
+    sym._id = n | VREG_BIT;
+    return sym;
+}
+
+ir::Symbol ir::Symbol::int_literal(int32_t v) {
+    Symbol sym;
+    sym._id = pool().literal_id(false, v);
+    return sym;
+}
+
+ir::Symbol ir::Symbol::float_literal(float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    Symbol sym;
+    sym._id = pool().literal_id(true, bits);
+    return sym;
+}
+
+bool ir::Symbol::is_float_literal() const {
+    return is_literal() && (pool().literal(_id) >> 32);
+}
+
+int32_t ir::Symbol::int_value() const {
+    assert(is_literal() && !is_float_literal() && "in Symbol::int_value, not an int literal");
+    return (int32_t)pool().literal(_id);
+}
+
+float ir::Symbol::float_value() const {
+    assert(is_float_literal() && "in Symbol::float_value, not a float literal");
+    uint32_t bits = (uint32_t)pool().literal(_id);
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+uint32_t ir::Symbol::hash() const {
+    if (is_vreg()) {
+        char buf[VREG_PREFIX_LEN + 10];
+        return fnv1a(buf, vreg_text(vreg_index(), buf));
+    }
+    if (is_literal()) {
+        const std::string& text = str();
+        return fnv1a(text.data(), text.size());
+    }
+    return pool().entry(_id).hash;
+}
+
+const std::string& ir::Symbol::str() const {
+    if (is_vreg())
+        return pool().vreg_str(vreg_index());
+    if (is_literal())
+        return pool().literal_str(_id);
+    return pool().entry(_id).text;
+}
+
+uint32_t ir::symbol_count() {
+    return pool().count;
+}
@@ -0,0 +1,56 @@
+#include "opt/analysis.h"
+
+ir::AnalysisManager::AnalysisManager(CFG &cfg) : cfg(cfg) {}
+
+const ir::DominatorTree &ir::AnalysisManager::dominators()
+{
+    if (!dom)
+        dom.reset(new DominatorTree(cfg));
+    return *dom;
+}
+
+const ir::DominatorTree &ir::AnalysisManager::post_dominators()
+{
+    if (!post_dom)
+        post_dom.reset(new DominatorTree(cfg, true));
+    return *post_dom;
+}
+
+const ir::LoopInfo &ir::AnalysisManager::loops()
+{
+    if (!loop_info)
+        loop_info.reset(new LoopInfo(cfg, dominators()));
+    return *loop_info;
+}
+
+uint32_t ir::AnalysisManager::insert_preheader(uint32_t l)
+{
+    loops();
+    size_t block_num = cfg.blocks.size();
+    uint32_t res = loop_info->insert_preheader(cfg, l);
+    if (cfg.blocks.size() != block_num)
+    {
+        dom.reset();
+        post_dom.reset();
+    }
+    return res;
+}
+
+void ir::AnalysisManager::insert_preheaders()
+{
+    size_t block_num = cfg.blocks.size();
+    for (uint32_t l = 0; l < loops().loops.size(); l++)
+        loop_info->insert_preheader(cfg, l);
+    if (cfg.blocks.size() != block_num)
+    {
+        dom.reset();
+        post_dom.reset();
+    }
+}
+
+void ir::AnalysisManager::invalidate()
+{
+    dom.reset();
+    post_dom.reset();
+    loop_info.reset();
+}
@@ -0,0 +1,55 @@
+#include "opt/passes.h"
+
+#include <unordered_map>
+
+void ir::CopyPropagation::run(Function &func, CFG &cfg, AnalysisManager &analyses)
+{
+    // vreg = src 之后, src 被赋值的次数不变时 vreg 可以用 src 代替;
+    // 进入新的基本块或者调用函数 (可能修改全局变量) 时 epoch 增加, 之前的复制都失效;
+    // phi 的值在前驱的末尾读取, 不在这里替换
+    struct Copy
+    {
+        Operand src;
+        uint32_t version;
+        uint32_t epoch;
+    };
+    std::unordered_map<Symbol, Copy> copies;
+    std::unordered_map<Symbol, uint32_t> version;
+    uint32_t epoch = 0;
+    auto replace = [&](Operand &op)
+    {
+        if (!op.name.is_vreg())
+            return;
+        auto iter = copies.find(op.name);
+        if (iter != copies.end() && iter->second.epoch == epoch && version[iter->second.src.name] == iter->second.version)
+            op = iter->second.src;
+    };
+
+    for (auto &block : cfg.blocks)
+    {
+        epoch++;
+        for (auto inst : block.insts)
+        {
+            replace(inst->op1);
+            replace(inst->op2);
+            if (!is_def(inst->op))
+                replace(inst->des);
+            if (inst->op == Operator::call)
+            {
+                for (auto &arg : static_cast<CallInst *>(inst)->argumentList)
+                    replace(arg);
+                epoch++;
+            }
+            if (!is_def(inst->op))
+                continue;
+
+            const Operand &des = inst->des, &src = inst->op1;
+            version[des.name]++;
+            copies.erase(des.name);
+            if ((inst->op == Operator::mov || inst->op == Operator::fmov) && des.name.is_vreg() && des.name != src.name &&
+                src.type == des.type && (src.type == Type::Int || src.type == Type::Float))
+                copies[des.name] = {src, version[src.name], epoch};
+        }
+        replace(block.cond);
+    }
+}
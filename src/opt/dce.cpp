@@ -0,0 +1,108 @@
+#include "opt/passes.h"
+
+#include <vector>
+#include <unordered_map>
+
+bool ir::is_pure(Operator op)
+{
+    switch (op)
+    {
+    case ir::Operator::_return:
+    case ir::Operator::_goto:
+    case ir::Operator::call:
+    case ir::Operator::alloc:
+    case ir::Operator::store:
+    case ir::Operator::fill:
+    case ir::Operator::copy:
+    case ir::Operator::__unuse__:
+        return false;
+    default:
+        return true;
+    }
+}
+
+bool ir::is_def(Operator op)
+{
+    return is_pure(op) || op == Operator::call || op == Operator::alloc;
+}
+
+void ir::DeadCodeElimination::run(Function &func, CFG &cfg, AnalysisManager &analyses)
+{
+    std::vector<Instruction *> insts;
+    insts.reserve(cfg.inst_count());
+    for (const auto &block : cfg.blocks)
+        insts.insert(insts.end(), block.insts.begin(), block.insts.end());
+
+    // vreg 按在函数中出现的顺序重新编号, 以及按 vreg 排列的定义它的指令
+    std::unordered_map<uint32_t, uint32_t> local_id;
+    auto visit = [&](Operand &op)
+    {
+        if (op.name.is_vreg())
+            local_id.insert({op.name.vreg_index(), (uint32_t)local_id.size()});
+    };
+    for (Instruction *inst : insts)
+    {
+        visit(inst->des);
+        for_each_use(inst, visit);
+    }
+    for (auto &block : cfg.blocks)
+        visit(block.cond);
+    uint32_t vreg_num = local_id.size();
+    auto id_of = [&](const Operand &op)
+    { return local_id.at(op.name.vreg_index()); };
+    auto is_removable = [&](const Instruction *inst)
+    { return is_pure(inst->op) && inst->des.name.is_vreg(); };
+
+    std::vector<uint32_t> def_begin(vreg_num + 1, 0);
+    for (const Instruction *inst : insts)
+        if (is_removable(inst))
+            def_begin[id_of(inst->des) + 1]++;
+    for (uint32_t v = 0; v < vreg_num; v++)
+        def_begin[v + 1] += def_begin[v];
+    std::vector<uint32_t> defs(def_begin[vreg_num]);
+    std::vector<uint32_t> def_end(def_begin.begin(), def_begin.end() - 1);
+    for (uint32_t i = 0; i < insts.size(); i++)
+        if (is_removable(insts[i]))
+            defs[def_end[id_of(insts[i]->des)]++] = i;
+
+    // 从有副作用的指令和跳转条件开始, 标记它们依赖的 vreg 的所有定义; 没有被标记的定义被删除, 包括互相依赖的 phi
+    std::vector<uint8_t> live(insts.size(), 0);
+    std::vector<uint8_t> live_vreg(vreg_num, 0);
+    std::vector<uint32_t> worklist;
+    auto mark = [&](Operand &op)
+    {
+        if (op.name.is_vreg() && !live_vreg[id_of(op)])
+        {
+            live_vreg[id_of(op)] = 1;
+            worklist.push_back(id_of(op));
+        }
+    };
+    for (uint32_t i = 0; i < insts.size(); i++)
+        if (!is_removable(insts[i]))
+        {
+            live[i] = 1;
+            for_each_use(insts[i], mark);
+        }
+    for (auto &block : cfg.blocks)
+        mark(block.cond);
+    while (!worklist.empty())
+    {
+        uint32_t v = worklist.back();
+        worklist.pop_back();
+        for (uint32_t k = def_begin[v]; k < def_begin[v + 1]; k++)
+        {
+            live[defs[k]] = 1;
+            for_each_use(insts[defs[k]], mark);
+        }
+    }
+
+    size_t i = 0;
+    for (auto &block : cfg.blocks)
+    {
+        size_t k = 0;
+        for (auto inst : block.insts)
+            if (live[i++])
+                block.insts[k++] = inst;
+        block.insts.resize(k);
+    }
+}
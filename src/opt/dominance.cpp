@@ -0,0 +1,131 @@
+#include "opt/dominance.h"
+
+#include <cassert>
+#include <algorithm>
+
+const uint32_t ir::DominatorTree::NONE;
+
+// 从 root 出发的逆后序, post 时沿着反向的边
+static std::vector<uint32_t> reverse_post_order(const ir::CFG &cfg, uint32_t root, bool post)
+{
+    std::vector<uint32_t> order;
+    std::vector<uint8_t> visited(cfg.blocks.size(), 0);
+    std::vector<std::pair<uint32_t, uint32_t>> stack = {{root, 0}};
+    visited[root] = 1;
+    while (!stack.empty())
+    {
+        auto &top = stack.back();
+        const auto &next = post ? cfg.blocks[top.first].preds : cfg.blocks[top.first].succs;
+        if (top.second < next.size())
+        {
+            uint32_t s = next[top.second++];
+            if (!visited[s])
+            {
+                visited[s] = 1;
+                stack.push_back({s, 0});
+            }
+        }
+        else
+        {
+            order.push_back(top.first);
+            stack.pop_back();
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+ir::DominatorTree::DominatorTree(const CFG &cfg, bool post_dom)
+    : idom(cfg.blocks.size(), NONE), children(cfg.blocks.size()), rpo(reverse_post_order(cfg, post_dom ? cfg.exit : cfg.entry, post_dom)),
+      root(post_dom ? cfg.exit : cfg.entry), is_post(post_dom)
+{
+    std::vector<uint32_t> order(cfg.blocks.size(), NONE);   // index in rpo
+    for (uint32_t i = 0; i < rpo.size(); i++)
+        order[rpo[i]] = i;
+
+    // 沿着 idom 向上走到两个块的公共祖先, rpo 中靠后的块先走
+    auto intersect = [&](uint32_t a, uint32_t b)
+    {
+        while (a != b)
+        {
+            while (order[a] > order[b])
+                a = idom[a];
+            while (order[b] > order[a])
+                b = idom[b];
+        }
+        return a;
+    };
+    idom[root] = root;
+    for (bool changed = true; changed;)
+    {
+        changed = false;
+        for (uint32_t i = 1; i < rpo.size(); i++)
+        {
+            uint32_t b = rpo[i], new_idom = NONE;
+            for (auto p : in_edges(cfg, b))
+                if (idom[p] != NONE)
+                    new_idom = new_idom == NONE ? p : intersect(p, new_idom);
+            if (idom[b] != new_idom)
+            {
+                idom[b] = new_idom;
+                changed = true;
+            }
+        }
+    }
+
+    for (auto b : rpo)
+        if (b != root)
+            children[idom[b]].push_back(b);
+
+    // 树的先序和后序编号, a 是 b 的祖先当且仅当 a 的区间包含 b
+    pre.assign(cfg.blocks.size(), NONE);
+    post.assign(cfg.blocks.size(), NONE);
+    uint32_t pre_cnt = 0, post_cnt = 0;
+    std::vector<std::pair<uint32_t, uint32_t>> stack = {{root, 0}};
+    pre[root] = pre_cnt++;
+    while (!stack.empty())
+    {
+        auto &top = stack.back();
+        if (top.second < children[top.first].size())
+        {
+            uint32_t c = children[top.first][top.second++];
+            pre[c] = pre_cnt++;
+            stack.push_back({c, 0});
+        }
+        else
+        {
+            post[top.first] = post_cnt++;
+            stack.pop_back();
+        }
+    }
+}
+
+bool ir::DominatorTree::dominates(uint32_t a, uint32_t b) const
+{
+    assert(is_reachable(a) && is_reachable(b) && "in DominatorTree::dominates, unreachable block");
+    return pre[a] <= pre[b] && post[b] <= post[a];
+}
+
+std::vector<std::vector<uint32_t>> ir::DominatorTree::frontiers(const CFG &cfg) const
+{
+    std::vector<std::vector<uint32_t>> df(cfg.blocks.size());
+    for (auto b : rpo)
+    {
+        const auto &preds = in_edges(cfg, b);
+        if (preds.size() < 2)
+            continue;
+        for (auto p : preds)
+        {
+            if (!is_reachable(p))
+                continue;
+            // b 只会被连续地加入同一个块的前沿, 所以只需要检查最后一个
+            for (uint32_t runner = p; runner != idom[b]; runner = idom[runner])
+            {
+                if (df[runner].size() && df[runner].back() == b)
+                    break;
+                df[runner].push_back(b);
+            }
+        }
+    }
+    return df;
+}
@@ -0,0 +1,168 @@
+#include "opt/loops.h"
+
+#include <cassert>
+#include <algorithm>
+#include <iostream>
+
+// #define DEBUG_LOOPS
+
+const uint32_t ir::LoopInfo::NONE;
+
+ir::LoopInfo::LoopInfo(const CFG &cfg, const DominatorTree &dom) : loop_of(cfg.blocks.size(), NONE)
+{
+    // 内层循环的 header 被外层的支配, 在 rpo 中靠后, 所以倒着处理 header 时内层循环先被找到;
+    // 从 latch 沿着前驱向上找循环体, 遇到已经属于内层循环的块时, 内层循环最外面的祖先成为当前循环的子循环, 从它的 header 继续
+    std::vector<uint32_t> parent;
+    auto outermost = [&](uint32_t l)
+    {
+        while (parent[l] != NONE)
+            l = parent[l];
+        return l;
+    };
+    std::vector<uint32_t> worklist;
+    for (auto iter = dom.rpo.rbegin(); iter != dom.rpo.rend(); iter++)
+    {
+        uint32_t h = *iter;
+        std::vector<uint32_t> latches;
+        for (auto p : cfg.blocks[h].preds)
+            if (dom.is_reachable(p) && dom.dominates(h, p) && std::find(latches.begin(), latches.end(), p) == latches.end())
+                latches.push_back(p);
+        if (latches.empty())
+            continue;
+
+        uint32_t l = loops.size();
+        loops.push_back({h, NONE, 0, {}, {}, latches});
+        parent.push_back(NONE);
+        loop_of[h] = l;
+        worklist = latches;
+        while (!worklist.empty())
+        {
+            uint32_t b = worklist.back();
+            worklist.pop_back();
+            if (loop_of[b] == NONE)
+                loop_of[b] = l;
+            else
+            {
+                uint32_t inner = outermost(loop_of[b]);
+                if (inner == l)
+                    continue;
+                parent[inner] = l;
+                b = loops[inner].header;
+            }
+            for (auto p : cfg.blocks[b].preds)
+                if (dom.is_reachable(p))
+                    worklist.push_back(p);
+        }
+    }
+
+    // 外层循环的编号更大
+    for (uint32_t l = loops.size(); l-- > 0;)
+    {
+        loops[l].parent = parent[l];
+        loops[l].depth = parent[l] == NONE ? 1 : loops[parent[l]].depth + 1;
+        if (parent[l] != NONE)
+            loops[parent[l]].children.push_back(l);
+        loops[l].blocks.push_back(loops[l].header);
+    }
+    for (uint32_t b = 0; b < cfg.blocks.size(); b++)
+        for (uint32_t l = loop_of[b]; l != NONE; l = loops[l].parent)
+            if (b != loops[l].header)
+                loops[l].blocks.push_back(b);
+
+#ifdef DEBUG_LOOPS
+    std::cout << draw();
+#endif
+}
+
+bool ir::LoopInfo::contains(uint32_t l, uint32_t b) const
+{
+    for (uint32_t x = loop_of[b]; x != NONE; x = loops[x].parent)
+        if (x == l)
+            return true;
+    return false;
+}
+
+uint32_t ir::LoopInfo::preheader(const CFG &cfg, uint32_t l) const
+{
+    uint32_t res = NONE;
+    for (auto p : cfg.blocks[loops[l].header].preds)
+    {
+        if (contains(l, p))
+            continue;
+        if (res != NONE)
+            return NONE;
+        res = p;
+    }
+    return res != NONE && cfg.blocks[res].succs.size() == 1 ? res : NONE;
+}
+
+uint32_t ir::LoopInfo::insert_preheader(CFG &cfg, uint32_t l)
+{
+    uint32_t res = preheader(cfg, l);
+    if (res != NONE)
+        return res;
+
+    uint32_t h = loops[l].header;
+    std::vector<size_t> entering;   // 从循环外进入的边在 header 的 preds 中的位置
+    for (size_t k = 0; k < cfg.blocks[h].preds.size(); k++)
+        if (!contains(l, cfg.blocks[h].preds[k]))
+            entering.push_back(k);
+    assert(entering.size() && "in LoopInfo::insert_preheader, the header is not reachable");
+
+    if (entering.size() == 1)
+        res = cfg.split_edge(cfg.blocks[h].preds[entering[0]], h);
+    else
+    {
+        // header 的 phi 中来自循环外的值先在 preheader 的新 phi 中合并
+        res = cfg.add_block();
+        for (auto inst : cfg.blocks[h].insts)
+        {
+            if (inst->op != Operator::phi)
+                break;
+            auto phi = static_cast<PhiInst *>(inst);
+            std::vector<Operand> incoming;
+            for (auto k : entering)
+                incoming.push_back(phi->incomingList[k]);
+            auto merged = new PhiInst(Operand(cfg.new_vreg(), phi->des.type), incoming);
+            cfg.blocks[res].insts.push_back(merged);
+            phi->incomingList.push_back(merged->des);
+        }
+        for (auto k : entering)
+        {
+            uint32_t p = cfg.blocks[h].preds[k];
+            *std::find(cfg.blocks[p].succs.begin(), cfg.blocks[p].succs.end(), h) = res;
+            cfg.blocks[res].preds.push_back(p);
+        }
+        // 新的 incoming 值已经在末尾, 与 add_edge 加入的前驱对应
+        for (size_t i = entering.size(); i-- > 0;)
+            cfg.blocks[h].remove_pred(entering[i]);
+        cfg.blocks[res].succs.push_back(h);
+        cfg.blocks[h].preds.push_back(res);
+    }
+
+    // preheader 在 l 的外层循环中
+    loop_of.push_back(loops[l].parent);
+    for (uint32_t x = loops[l].parent; x != NONE; x = loops[x].parent)
+        loops[x].blocks.push_back(res);
+    return res;
+}
+
+std::string ir::LoopInfo::draw() const
+{
+    std::string res;
+    for (uint32_t l = 0; l < loops.size(); l++)
+    {
+        const Loop &loop = loops[l];
+        res += "L" + std::to_string(l) + ":\theader: B" + std::to_string(loop.header) + "\tdepth: " + std::to_string(loop.depth);
+        if (loop.parent != NONE)
+            res += "\tparent: L" + std::to_string(loop.parent);
+        res += "\tblocks:";
+        for (auto b : loop.blocks)
+            res += " B" + std::to_string(b);
+        res += "\tlatches:";
+        for (auto b : loop.latches)
+            res += " B" + std::to_string(b);
+        res += "\n";
+    }
+    return res;
+}
@@ -0,0 +1,239 @@
+#include "opt/passes.h"
+
+#include <cassert>
+#include <iostream>
+#include <unordered_map>
+
+// #define DEBUG_MEM2REG
+
+void ir::Mem2Reg::init(Program &program)
+{
+    globals.clear();
+    for (const auto &global : program.globalVal)
+        globals.insert(global.val.name);
+}
+
+void ir::Mem2Reg::run(Function &func, CFG &cfg, AnalysisManager &analyses)
+{
+    if (cfg.remove_unreachable())
+        analyses.invalidate();
+    const DominatorTree &dom = analyses.dominators();
+    auto &blocks = cfg.blocks;
+
+    struct Var
+    {
+        Operand op;                         // 名字和类型
+        uint32_t def_num = 0;
+        std::vector<uint32_t> def_blocks;   // 可能有重复
+        bool mixed = false;                 // 同一个名字有 Int 和 Float 两种类型, 不转换
+        bool dominated = true;              // vreg 的所有使用都被唯一的定义支配
+        bool is_global_name = false;        // 在某个基本块中先使用后定义, 只有这样的变量需要 phi
+        bool promoted = false;
+    };
+    std::vector<Var> vars;
+    std::unordered_map<Symbol, uint32_t> var_id;
+    auto is_candidate = [&](const Operand &op)
+    { return (op.type == Type::Int || op.type == Type::Float) && !op.name.is_literal() && !globals.count(op.name); };
+    auto add_def = [&](const Operand &op, uint32_t b)
+    {
+        auto iter = var_id.insert({op.name, (uint32_t)vars.size()}).first;
+        if (iter->second == vars.size())
+        {
+            vars.emplace_back();
+            vars.back().op = op;
+        }
+        Var &var = vars[iter->second];
+        var.mixed |= var.op.type != op.type;
+        var.def_num++;
+        var.def_blocks.push_back(b);
+    };
+
+    // 找到所有局部变量和写入的 vreg, 参数在入口被定义
+    for (const auto &param : func.ParameterList)
+        if (is_candidate(param))
+            add_def(param, cfg.entry);
+    for (uint32_t b = 0; b < blocks.size(); b++)
+        for (auto inst : blocks[b].insts)
+            if (is_def(inst->op) && is_candidate(inst->des))
+                add_def(inst->des, b);
+
+    // 检查使用: 类型, 是否被唯一的定义支配, 是否在基本块中先使用后定义
+    std::vector<uint32_t> def_stamp(vars.size(), DominatorTree::NONE);   // 在当前基本块中已经定义过
+    for (const auto &param : func.ParameterList)
+        if (var_id.count(param.name))
+            def_stamp[var_id[param.name]] = cfg.entry;
+    for (uint32_t b = 0; b < blocks.size(); b++)
+    {
+        auto use = [&](Operand &op)
+        {
+            auto iter = var_id.find(op.name);
+            if (iter == var_id.end())
+                return;
+            Var &var = vars[iter->second];
+            var.mixed |= var.op.type != op.type;
+            if (def_stamp[iter->second] != b)
+            {
+                var.is_global_name = true;
+                if (var.def_num == 1 && (var.def_blocks[0] == b || !dom.dominates(var.def_blocks[0], b)))
+                    var.dominated = false;
+            }
+        };
+        for (auto inst : blocks[b].insts)
+        {
+            for_each_use(inst, use);
+            auto iter = is_def(inst->op) ? var_id.find(inst->des.name) : var_id.end();
+            if (iter != var_id.end())
+                def_stamp[iter->second] = b;
+        }
+        use(blocks[b].cond);
+    }
+    for (auto &var : vars)
+        var.promoted = !var.mixed && (!var.op.name.is_vreg() || var.def_num > 1 || !var.dominated);
+
+    // 在定义的迭代支配边界上放置 phi
+    auto df = dom.frontiers(cfg);
+    std::vector<std::vector<uint32_t>> phi_vars(blocks.size());
+    std::vector<uint32_t> has_phi(blocks.size(), DominatorTree::NONE), in_work(blocks.size(), DominatorTree::NONE);
+    std::vector<uint32_t> worklist;
+    for (uint32_t v = 0; v < vars.size(); v++)
+    {
+        if (!vars[v].promoted || !vars[v].is_global_name)
+            continue;
+        worklist.clear();
+        for (auto b : vars[v].def_blocks)
+            if (in_work[b] != v)
+            {
+                in_work[b] = v;
+                worklist.push_back(b);
+            }
+        while (!worklist.empty())
+        {
+            uint32_t b = worklist.back();
+            worklist.pop_back();
+            for (auto f : df[b])
+            {
+                if (has_phi[f] == v)
+                    continue;
+                has_phi[f] = v;
+                phi_vars[f].push_back(v);
+                if (in_work[f] != v)
+                {
+                    in_work[f] = v;
+                    worklist.push_back(f);
+                }
+            }
+        }
+    }
+    for (uint32_t b = 0; b < blocks.size(); b++)
+    {
+        std::vector<Instruction *> phis;
+        for (auto v : phi_vars[b])
+            phis.push_back(new PhiInst(vars[v].op, std::vector<Operand>(blocks[b].preds.size(), vars[v].op)));
+        blocks[b].insts.insert(blocks[b].insts.begin(), phis.begin(), phis.end());
+    }
+
+    // 沿支配树重命名, 每个变量的当前值在栈顶, 离开基本块时弹出在其中压入的值; 没有定义的变量的值为 0
+    std::vector<std::vector<Operand>> stacks(vars.size());
+    std::vector<uint32_t> pushed;
+    for (const auto &param : func.ParameterList)
+        if (var_id.count(param.name) && vars[var_id[param.name]].promoted)
+            stacks[var_id[param.name]].push_back(param);
+    auto value_of = [&](uint32_t v)
+    {
+        if (stacks[v].size())
+            return stacks[v].back();
+        return vars[v].op.type == Type::Float ? Operand(Symbol::float_literal(0), Type::FloatLiteral) : Operand(Symbol::int_literal(0), Type::IntLiteral);
+    };
+    auto push = [&](uint32_t v, const Operand &value)
+    {
+        stacks[v].push_back(value);
+        pushed.push_back(v);
+    };
+    // 重命名之后不会再被赋值的值: 新的 vreg, 参数的初值 (参数的赋值都被重命名了), 支配所有使用的唯一定义的 vreg, 对它们的复制可以直接删除
+    auto is_stable = [&](const Operand &op)
+    {
+        auto iter = var_id.find(op.name);
+        if (iter == var_id.end())
+            return op.name.is_vreg();
+        const Var &var = vars[iter->second];
+        return var.promoted || (!var.mixed && var.op.name.is_vreg());
+    };
+    auto rename_use = [&](Operand &op)
+    {
+        auto iter = var_id.find(op.name);
+        if (iter == var_id.end() || !vars[iter->second].promoted)
+            return;
+        Operand value = value_of(iter->second);
+        op.name = value.name;
+        if (value.type == Type::IntLiteral || value.type == Type::FloatLiteral)
+            op.type = value.type;
+    };
+
+    std::vector<std::pair<uint32_t, size_t>> stack = {{cfg.entry, 0}};
+    std::vector<size_t> pushed_size;
+    while (!stack.empty())
+    {
+        uint32_t b = stack.back().first;
+        if (stack.back().second == 0)
+        {
+            pushed_size.push_back(pushed.size());
+            BasicBlock &block = blocks[b];
+            size_t k = 0;
+            for (auto inst : block.insts)
+            {
+                if (inst->op == Operator::phi)
+                {
+                    inst->des.name = cfg.new_vreg();
+                    push(phi_vars[b][k], inst->des);
+                    block.insts[k++] = inst;
+                    continue;
+                }
+                for_each_use(inst, rename_use);
+                auto iter = is_def(inst->op) ? var_id.find(inst->des.name) : var_id.end();
+                if (iter == var_id.end() || !vars[iter->second].promoted)
+                {
+                    block.insts[k++] = inst;
+                    continue;
+                }
+                bool is_copy = inst->op == Operator::mov || inst->op == Operator::fmov || inst->op == Operator::def || inst->op == Operator::fdef;
+                // 复制之后直接使用原来的值, 由 out-of-ssa 在需要时重新生成复制
+                if (is_copy && inst->op1.type == inst->des.type && (inst->op1.type == Type::Int || inst->op1.type == Type::Float) && is_stable(inst->op1))
+                {
+                    push(iter->second, inst->op1);
+                    continue;
+                }
+                inst->des.name = cfg.new_vreg();
+                push(iter->second, inst->des);
+                block.insts[k++] = inst;
+            }
+            block.insts.resize(k);
+            rename_use(block.cond);
+
+            for (auto s : block.succs)
+            {
+                const auto &preds = blocks[s].preds;
+                for (size_t p = 0; p < preds.size(); p++)
+                {
+                    if (preds[p] != b)
+                        continue;
+                    for (size_t j = 0; j < phi_vars[s].size(); j++)
+                        static_cast<PhiInst *>(blocks[s].insts[j])->incomingList[p] = value_of(phi_vars[s][j]);
+                }
+            }
+        }
+        if (stack.back().second < dom.children[b].size())
+        {
+            uint32_t c = dom.children[b][stack.back().second++];
+            stack.push_back({c, 0});
+            continue;
+        }
+        for (size_t n = pushed_size.back(); pushed.size() > n; pushed.pop_back())
+            stacks[pushed.back()].pop_back();
+        pushed_size.pop_back();
+        stack.pop_back();
+    }
+
+#ifdef DEBUG_MEM2REG
+    std::cout << func.name << " in SSA:\n" << cfg.draw();
+#endif
+}
@@ -0,0 +1,167 @@
+#include "opt/passes.h"
+
+#include <cassert>
+#include <iostream>
+#include <unordered_map>
+
+// #define DEBUG_OUT_OF_SSA
+
+// 把一组并行的复制 dst_i = src_i 排成顺序的 mov, 追加到 insts 的末尾;
+// 先生成 dst 不再被读取的复制, 剩下的都在环上, 把环上的一个 dst 先存到新的 vreg 中
+static void sequentialize(std::vector<std::pair<ir::Operand, ir::Operand>> &copies, ir::CFG &cfg, std::vector<ir::Instruction *> &insts)
+{
+    using namespace ir;
+    auto emit = [&](const Operand &dst, const Operand &src)
+    { insts.push_back(new Instruction(src, Operand(), dst, dst.type == Type::Float ? Operator::fmov : Operator::mov)); };
+
+    std::unordered_map<Symbol, std::vector<size_t>> readers;   // 读取某个值的复制
+    std::unordered_map<Symbol, size_t> writer;                 // 写入某个值的复制
+    std::vector<size_t> ready;
+    std::vector<bool> done(copies.size(), false);
+    for (size_t i = 0; i < copies.size(); i++)
+    {
+        readers[copies[i].second.name].push_back(i);
+        writer[copies[i].first.name] = i;
+    }
+    auto unread = [&](const Symbol &name)
+    {
+        auto iter = readers.find(name);
+        if (iter == readers.end())
+            return true;
+        for (auto i : iter->second)
+            if (!done[i])
+                return false;
+        return true;
+    };
+    for (size_t i = 0; i < copies.size(); i++)
+        if (unread(copies[i].first.name))
+            ready.push_back(i);
+
+    for (size_t remain = copies.size(), next = 0; remain;)
+    {
+        while (!ready.empty())
+        {
+            size_t i = ready.back();
+            ready.pop_back();
+            emit(copies[i].first, copies[i].second);
+            done[i] = true;
+            remain--;
+            // src 的最后一个读取完成后, 写入 src 的复制可以生成了
+            auto iter = writer.find(copies[i].second.name);
+            if (iter != writer.end() && !done[iter->second] && unread(copies[i].second.name))
+                ready.push_back(iter->second);
+        }
+        if (!remain)
+            break;
+        while (done[next])
+            next++;
+        // 环: dst 的旧值保存到 t, 读取 dst 的复制改为读取 t
+        const Operand dst = copies[next].first;
+        Operand t(cfg.new_vreg(), dst.type);
+        emit(t, dst);
+        std::vector<size_t> moved;
+        for (auto i : readers[dst.name])
+            if (!done[i])
+            {
+                copies[i].second = t;
+                moved.push_back(i);
+            }
+        readers.erase(dst.name);
+        readers[t.name] = moved;
+        ready.push_back(next);
+    }
+}
+
+// d = ...; ...; mov x, d 中 d 只在这里被读取, 中间也没有读写 x 时, 直接写入 x 并删除复制
+static void coalesce(ir::CFG &cfg)
+{
+    using namespace ir;
+    std::unordered_map<Symbol, uint32_t> use_num, def_num;
+    for (auto &block : cfg.blocks)
+    {
+        for (auto inst : block.insts)
+        {
+            for_each_use(inst, [&](Operand &op)
+                         { if (op.name.is_vreg()) use_num[op.name]++; });
+            if (is_def(inst->op) && inst->des.name.is_vreg())
+                def_num[inst->des.name]++;
+        }
+        if (block.cond.name.is_vreg())
+            use_num[block.cond.name]++;
+    }
+
+    std::unordered_map<Symbol, size_t> last_mention, def_pos;   // 基本块中最后一次出现和定义的位置
+    for (auto &block : cfg.blocks)
+    {
+        last_mention.clear();
+        def_pos.clear();
+        size_t k = 0;
+        for (size_t i = 0; i < block.insts.size(); i++)
+        {
+            Instruction *inst = block.insts[i];
+            const Operand &x = inst->des, &d = inst->op1;
+            if ((inst->op == Operator::mov || inst->op == Operator::fmov) && x.name.is_vreg() && d.name.is_vreg() && x.type == d.type &&
+                use_num[d.name] == 1 && def_num[d.name] == 1 && def_pos.count(d.name))
+            {
+                // 定义 d 的指令本身可以读取 x
+                size_t pos = def_pos[d.name];
+                auto mention = last_mention.find(x.name);
+                if (mention == last_mention.end() || mention->second <= pos)
+                {
+                    block.insts[pos]->des = x;
+                    last_mention[x.name] = def_pos[x.name] = pos;
+                    continue;
+                }
+            }
+            for_each_use(inst, [&](Operand &op)
+                         { last_mention[op.name] = k; });
+            if (is_def(inst->op))
+                last_mention[x.name] = def_pos[x.name] = k;
+            block.insts[k++] = inst;
+        }
+        block.insts.resize(k);
+    }
+}
+
+void ir::OutOfSSA::run(Function &func, CFG &cfg, AnalysisManager &analyses)
+{
+    size_t block_num = cfg.blocks.size();
+    for (uint32_t b = 0; b < cfg.blocks.size(); b++)
+    {
+        size_t phi_num = 0;
+        while (phi_num < cfg.blocks[b].insts.size() && cfg.blocks[b].insts[phi_num]->op == Operator::phi)
+            phi_num++;
+        if (!phi_num)
+            continue;
+
+        // 关键边上的复制只能放在新的基本块中, split_edge 不改变前驱的顺序
+        for (size_t k = 0; k < cfg.blocks[b].preds.size(); k++)
+        {
+            uint32_t p = cfg.blocks[b].preds[k];
+            if (cfg.blocks[p].succs.size() > 1)
+                p = cfg.split_edge(p, b);
+            assert(!cfg.blocks[p].is_return() && "in OutOfSSA::run, a block which returns has a phi successor");
+
+            std::vector<std::pair<Operand, Operand>> copies;
+            for (size_t j = 0; j < phi_num; j++)
+            {
+                auto phi = static_cast<PhiInst *>(cfg.blocks[b].insts[j]);
+                if (phi->incomingList[k].name != phi->des.name)
+                    copies.push_back({phi->des, phi->incomingList[k]});
+            }
+            sequentialize(copies, cfg, cfg.blocks[p].insts);
+        }
+
+        auto &insts = cfg.blocks[b].insts;
+        for (size_t j = 0; j < phi_num; j++)
+            delete insts[j];
+        insts.erase(insts.begin(), insts.begin() + phi_num);
+    }
+    if (cfg.blocks.size() != block_num)
+        analyses.invalidate();
+    coalesce(cfg);
+
+#ifdef DEBUG_OUT_OF_SSA
+    std::cout << func.name << " out of SSA:\n" << cfg.draw();
+#endif
+}
@@ -0,0 +1,136 @@
+#include "opt/pass_manager.h"
+#include "opt/passes.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+// #define DEBUG_PASS_MANAGER
+
+size_t count_inst(const std::vector<ir::CFG> &cfgs)
+{
+    size_t n = 0;
+    for (const auto &cfg : cfgs)
+        n += cfg.lowered_size();
+    return n;
+}
+
+ir::PassManager::PassManager() : level(0), time_report(false)
+{
+    add_pass(new SimplifyCFG(), 1);
+    add_pass(new Mem2Reg(), 2);
+    add_pass(new CopyPropagation(), 1);
+    add_pass(new DeadCodeElimination(), 1);
+    add_pass(new OutOfSSA(), 2);
+}
+
+ir::PassManager::~PassManager()
+{
+    for (auto &entry : passes)
+        delete entry.pass;
+}
+
+void ir::PassManager::add_pass(Pass *pass, int level)
+{
+    passes.push_back({pass, level, 0, 0, 0, false});
+}
+
+bool ir::PassManager::set_option(const std::string &opt)
+{
+    if (opt.size() == 3 && opt[0] == '-' && opt[1] == 'O' && opt[2] >= '0' && opt[2] <= '9')
+        level = opt[2] - '0';
+    else if (opt == "-ftime-report")
+        time_report = true;
+    else if (opt.compare(0, 2, "-f") == 0)
+    {
+        bool enable = opt.compare(0, 5, "-fno-") != 0;
+        std::string name = opt.substr(enable ? 2 : 5);
+        for (const auto &entry : passes)
+            if (name == entry.pass->name())
+            {
+                switches[name] = enable;
+                return true;
+            }
+        return false;
+    }
+    else
+        return false;
+    return true;
+}
+
+bool ir::PassManager::is_selected(const PassEntry &entry) const
+{
+    auto iter = switches.find(entry.pass->name());
+    if (iter != switches.end())
+        return iter->second;
+    return level >= entry.level;
+}
+
+bool ir::PassManager::is_enabled(const std::string &name) const
+{
+    for (const auto &entry : passes)
+        if (is_selected(entry) && entry.pass->required_pass() && name == entry.pass->required_pass())
+            return true;
+    for (const auto &entry : passes)
+        if (name == entry.pass->name())
+            return is_selected(entry);
+    return false;
+}
+
+void ir::PassManager::run(Program &program)
+{
+    bool any = false;
+    for (const auto &entry : passes)
+        any |= is_enabled(entry.pass->name());
+    if (!any)
+        return;
+
+    std::vector<CFG> cfgs;
+    cfgs.reserve(program.functions.size());
+    for (const auto &func : program.functions)
+        cfgs.emplace_back(func);
+    std::vector<AnalysisManager> analyses;
+    analyses.reserve(cfgs.size());
+    for (auto &cfg : cfgs)
+        analyses.emplace_back(cfg);
+
+    for (auto &entry : passes)
+    {
+        if (!is_enabled(entry.pass->name()))
+            continue;
+        entry.inst_before = count_inst(cfgs);
+        auto begin = std::chrono::steady_clock::now();
+        entry.pass->init(program);
+        for (size_t i = 0; i < cfgs.size(); i++)
+            entry.pass->run(program.functions[i], cfgs[i], analyses[i]);
+        entry.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        entry.inst_after = count_inst(cfgs);
+        entry.ran = true;
+#ifdef DEBUG_PASS_MANAGER
+        std::cout << "after " << entry.pass->name() << ":\n";
+        for (size_t i = 0; i < cfgs.size(); i++)
+            std::cout << program.functions[i].name << ":\n" << cfgs[i].draw();
+#endif
+    }
+
+    for (size_t i = 0; i < cfgs.size(); i++)
+        cfgs[i].lower(program.functions[i]);
+
+    if (time_report)
+        std::cerr << report();
+}
+
+std::string ir::PassManager::report() const
+{
+    std::string res;
+    char line[128];
+    for (const auto &entry : passes)
+    {
+        if (!entry.ran)
+            continue;
+        snprintf(line, sizeof(line), "%-16s %10.3f ms %10zu -> %10zu instructions\n", entry.pass->name(),
+                 entry.seconds * 1000, entry.inst_before, entry.inst_after);
+        res += line;
+    }
+    return res;
+}
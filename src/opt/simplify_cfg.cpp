@@ -0,0 +1,51 @@
+#include "opt/passes.h"
+
+#include <algorithm>
+
+void ir::SimplifyCFG::run(Function &func, CFG &cfg, AnalysisManager &analyses)
+{
+    auto &blocks = cfg.blocks;
+
+    // 空的基本块只有一个无条件跳转, 跳到它的边直接跳到它的后继; 最多走 blocks.size() 步, 空的死循环不会卡住
+    auto forward = [&](uint32_t b)
+    {
+        for (size_t step = 0; step < blocks.size(); step++)
+        {
+            const BasicBlock &block = blocks[b];
+            if (b == cfg.exit || block.insts.size() || block.cond.type != Type::null || block.succs.size() != 1 || block.succs[0] == b)
+                break;
+            b = block.succs[0];
+        }
+        return b;
+    };
+    bool changed = false;
+    for (uint32_t b = 0; b < blocks.size(); b++)
+    {
+        for (size_t k = 0; k < blocks[b].succs.size(); k++)
+        {
+            uint32_t s = blocks[b].succs[k];
+            uint32_t to = forward(s);
+            if (to == s)
+                continue;
+            blocks[b].succs[k] = to;
+            auto &preds = blocks[s].preds;
+            blocks[s].remove_pred(std::find(preds.begin(), preds.end(), b) - preds.begin());
+            blocks[to].preds.push_back(b);
+            changed = true;
+        }
+        // 两个后继相同的条件跳转不再需要
+        BasicBlock &block = blocks[b];
+        if (block.cond.type != Type::null && block.succs[0] == block.succs[1])
+        {
+            auto &preds = blocks[block.succs[1]].preds;
+            blocks[block.succs[1]].remove_pred(std::find(preds.begin(), preds.end(), b) - preds.begin());
+            block.succs.pop_back();
+            block.cond = Operand();
+            changed = true;
+        }
+    }
+
+    changed |= cfg.remove_unreachable();
+    if (changed)
+        analyses.invalidate();
+}
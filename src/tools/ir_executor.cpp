@@ -4,6 +4,7 @@
 
 #include<stdio.h>
 #include<cassert>
+#include<cstring>
 #include<iostream>
 
 #define TODO assert(0 && "TODO");
@@ -33,9 +34,9 @@ int ir::eval_int(std::string s) {
     }
 }
 
-ir::Context::Context(const ir::Function* pf): pc(0), retval_addr(nullptr), mem(std::map<std::string, Value>()), pfunc(pf) {} 
+ir::Context::Context(const ir::Function* pf): pc(0), retval_addr(nullptr), mem(std::unordered_map<Symbol, Value>()), vregs(), pfunc(pf) {} 
 
-ir::Executor::Executor(const ir::Program* pp, std::ostream& os): out(os), program(pp), global_vars(std::map<std::string, Value>()), cur_ctx(nullptr), cxt_stack(std::stack<Context*>()) {}
+ir::Executor::Executor(const ir::Program* pp, std::ostream& os): out(os), program(pp), global_vars(std::unordered_map<Symbol, Value>()), cur_ctx(nullptr), cxt_stack(std::stack<Context*>()) {}
 
 ir::Value ir::Executor::find_src_operand(Operand op) {
 #if (DEBUG_EXEC_DETAIL)
@@ -43,21 +44,33 @@ ir::Value ir::Executor::find_src_operand(Operand op) {
 #endif
     ir::Value retval;
     
+    // literals made by the frontend keep their values, the text is only read for literals from other places
     if (op.type == Type::IntLiteral) {
+        if (op.name.is_literal() && !op.name.is_float_literal())
+            return {Type::Int, op.name.int_value()};
         return {Type::Int, eval_int(op.name)};
     }
     else if (op.type == Type::FloatLiteral) {
         retval.t = Type::Float;
-        retval._val.fval = (float)std::atof(op.name.c_str());
+        if (op.name.is_float_literal())
+            retval._val.fval = op.name.float_value();
+        else
+            retval._val.fval = (float)std::atof(op.name.c_str());
         return retval;
     }
 
-    auto iter = cur_ctx->mem.find(op.name);
-    if (iter == cur_ctx->mem.end()) {
-        iter = global_vars.find(op.name);
-        assert(iter != global_vars.end() && "can not find the arguement in current conxtext or global variables");
-    } 
-    retval = iter->second;
+    // vregs are found by their number, other names by the hash tables
+    if (op.name.is_vreg() && op.name.vreg_index() < cur_ctx->vregs.size() && cur_ctx->vregs[op.name.vreg_index()].t != Type::null) {
+        retval = cur_ctx->vregs[op.name.vreg_index()];
+    }
+    else {
+        auto iter = cur_ctx->mem.find(op.name);
+        if (iter == cur_ctx->mem.end()) {
+            iter = global_vars.find(op.name);
+            assert(iter != global_vars.end() && "can not find the arguement in current conxtext or global variables");
+        } 
+        retval = iter->second;
+    }
     assert(retval.t == op.type && "type not match");
 #if (DEBUG_EXEC_DETAIL)
     std::cout << ", value = ";
@@ -83,21 +96,34 @@ ir::Value* ir::Executor::get_des_operand(Operand op) {
     std::cout << "\tin get_des_operand(" << toString(op.type) << " " << op.name  << ")";
 #endif
     ir::Value* retval = nullptr;
-    auto iter = cur_ctx->mem.find(op.name);
-    if (iter != cur_ctx->mem.end()) {                   // find the operand in current context
-        retval = &iter->second;
+    if (op.name.is_vreg() && op.name.vreg_index() < cur_ctx->vregs.size() && cur_ctx->vregs[op.name.vreg_index()].t != Type::null) {
+        retval = &cur_ctx->vregs[op.name.vreg_index()];   // vregs are found by their number
     }
     else {
-        iter = global_vars.find(op.name);
-        if (iter != global_vars.end()) {               // find the operand in global variable
+        auto iter = cur_ctx->mem.find(op.name);
+        if (iter != cur_ctx->mem.end()) {                   // find the operand in current context
             retval = &iter->second;
         }
-        else {                                              // both not, then create a new one
+        else {
+            iter = global_vars.find(op.name);
+            if (iter != global_vars.end()) {               // find the operand in global variable
+                retval = &iter->second;
+            }
+            else {                                              // both not, then create a new one
 #if (DEBUG_EXEC_DETAIL)
     std::cout << ", new des (" << toString(op.type) << " " << op.name  << ")";
 #endif
-            cur_ctx->mem.insert({op.name, {op.type, 0}});
-            retval = &cur_ctx->mem.find(op.name)->second;
+                if (op.name.is_vreg()) {
+                    if (cur_ctx->vregs.size() <= op.name.vreg_index())
+                        cur_ctx->vregs.resize(op.name.vreg_index() + 1, {Type::null, 0});
+                    cur_ctx->vregs[op.name.vreg_index()] = {op.type, 0};
+                    retval = &cur_ctx->vregs[op.name.vreg_index()];
+                }
+                else {
+                    cur_ctx->mem.insert({op.name, {op.type, 0}});
+                    retval = &cur_ctx->mem.find(op.name)->second;
+                }
+            }
         }
     }
 
@@ -123,7 +149,7 @@ ir::Value* ir::Executor::get_des_operand(Operand op) {
 int ir::Executor::run() {
     // init global variables
     for(const auto& gte: program->globalVal) {
-        std::pair<std::string, Value> entry = {gte.val.name, {gte.val.type, 0}};
+        std::pair<Symbol, Value> entry = {gte.val.name, {gte.val.type, 0}};
         if (gte.maxlen) {
             if (gte.val.type == Type::IntPtr) {
                 entry.second._val.iptr = new int[gte.maxlen];
@@ -143,6 +169,13 @@ int ir::Executor::run() {
             else {
                 assert(0 && "wrong global value type with maxlen > 0");
             }
+            // static initial values, the words after init are 0
+            assert(gte.init.size() <= (size_t)gte.maxlen && "too many initial values");
+            void* data = gte.val.type == Type::IntPtr ? (void*)entry.second._val.iptr : (void*)entry.second._val.fptr;
+            memcpy(data, gte.init.data(), gte.init.size() * sizeof(uint32_t));
+        }
+        else if (gte.init.size()) {
+            memcpy(&entry.second._val, gte.init.data(), sizeof(uint32_t));
         }
         global_vars.insert(entry);
     }
@@ -326,6 +359,33 @@ bool ir::Executor::exec_ir(size_t n) {
                     assert(0 && "in Operator::store, op1 should be a pointer and des should be the matched type");
                 }
             } break;
+            case Operator::fill: {
+                assert(IS_INT_OPERAND(inst->op2) && IS_INT_OPERAND(inst->des) && "in Operator::fill, op2 and des should be integer");
+                int off = find_src_operand(inst->op2)._val.ival;
+                int cnt = find_src_operand(inst->des)._val.ival;
+                if (inst->op1.type == Type::IntPtr) {
+                    memset(find_src_operand(inst->op1)._val.iptr + off, 0, cnt * sizeof(int));
+                }
+                else if (inst->op1.type == Type::FloatPtr) {
+                    memset(find_src_operand(inst->op1)._val.fptr + off, 0, cnt * sizeof(float));
+                }
+                else {
+                    assert(0 && "in Operator::fill, op1 should be a pointer");
+                }
+            } break;
+            case Operator::copy: {
+                assert(IS_INT_OPERAND(inst->des) && "in Operator::copy, des should be integer");
+                int cnt = find_src_operand(inst->des)._val.ival;
+                if (inst->op1.type == Type::IntPtr && inst->op2.type == Type::IntPtr) {
+                    memcpy(find_src_operand(inst->op1)._val.iptr, find_src_operand(inst->op2)._val.iptr, cnt * sizeof(int));
+                }
+                else if (inst->op1.type == Type::FloatPtr && inst->op2.type == Type::FloatPtr) {
+                    memcpy(find_src_operand(inst->op1)._val.fptr, find_src_operand(inst->op2)._val.fptr, cnt * sizeof(float));
+                }
+                else {
+                    assert(0 && "in Operator::copy, op1 and op2 should be pointers of the same type");
+                }
+            } break;
             case Operator::load: {
                 int off;
                 if (IS_INT_OPERAND(inst->op2)) {
@@ -591,6 +651,9 @@ bool ir::Executor::exec_ir(size_t n) {
             } break;
         case Operator::__unuse__:
             break;
+        case Operator::phi:
+            assert(0 && "in Executor::run, phi should be removed by out-of-ssa");
+            break;
         // default:
         //     break;
         }